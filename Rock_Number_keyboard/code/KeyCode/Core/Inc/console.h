@@ -0,0 +1,58 @@
+#ifndef __CONSOLE_H
+#define __CONSOLE_H
+
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+#include "usbd_conf.h"
+
+// USB CDC-ACM 诊断控制台（usbd_conf.h 中 USBD_CDC_CONSOLE = 1 时启用，Linux主机上为 /dev/ttyACMx；USB类见 usbd_cdc_console.c）。
+// 输出先写入无锁发送环：任意上下文（包括扫描ISR）都可以写，从不阻塞，环满时整条丢弃并计数；
+// USB中断在每个SOF/DataIn从环中取数据装载到CDC批量IN端点，主机打开串口（DTR）后才发送。
+// 输入按行在主循环中执行：help / stats / scan [hz] / debounce [sym|eager|pk]。
+// 未启用时以下函数均为空操作，调用处无需条件编译。
+
+#define CONSOLE_TX_SIZE     1024U  // 发送环长度（2的幂）
+#define CONSOLE_RX_SIZE     64U    // 接收环长度（2的幂）
+#define CONSOLE_LINE_SIZE   32U    // 命令行最大长度（含结尾0）
+#define CONSOLE_PRINTF_SIZE 96U    // Console_Printf 单条消息最大长度，超出部分截断
+
+#if (USBD_CDC_CONSOLE == 1U)
+
+/**
+ * @brief 写入len字节；剩余空间不足时整条丢弃。可在任意中断中调用。
+ */
+void Console_Write(const char *data, uint16_t len);
+
+void Console_Print(const char *str);
+
+/**
+ * @brief 格式化后写入（在调用者栈上格式化，最长 CONSOLE_PRINTF_SIZE - 1 字节）。
+ */
+void Console_Printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief 在主循环中调用：回显收到的字符，收到整行后执行命令。
+ */
+void Console_Process(void);
+
+/**
+ * @brief 因发送环满被丢弃的累计字节数。
+ */
+uint32_t Console_GetDropped(void);
+
+/**
+ * @brief stats 命令中由应用补充的统计（弱函数，默认为空），在主循环中调用。
+ */
+void Console_AppStats(void);
+
+#else
+
+static inline void Console_Write(const char *data, uint16_t len) { (void)data; (void)len; }
+static inline void Console_Print(const char *str) { (void)str; }
+static inline void Console_Printf(const char *fmt, ...) { (void)fmt; }
+static inline void Console_Process(void) {}
+static inline uint32_t Console_GetDropped(void) { return 0; }
+
+#endif // USBD_CDC_CONSOLE
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef __KEYBOARD_REPORT_H
+#define __KEYBOARD_REPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 增量键盘报告：以按键跳变为单位维护当前按住的键，按需序列化为启动报告或NKRO报告。
+// 用法 0x01-0xDF 存在位图中，0xE0-0xE7 为修饰键，0xE8 及以上不是键盘用法，一律忽略；另有键→启动报告槽位索引，
+// 按下/释放都是常数时间，重复按下不会产生重复键码。
+
+#define KEYBOARD_REPORT_BITMAP_SIZE  28U   // 用法 0x00-0xDF
+#define KEYBOARD_REPORT_BOOT_KEYS    6U    // 启动报告的键码槽位数
+#define KEYBOARD_REPORT_BOOT_SIZE    8U    // 修饰键、保留、6个键码
+#define KEYBOARD_REPORT_NKRO_SIZE    (2U + KEYBOARD_REPORT_BITMAP_SIZE)  // 报告ID、修饰键、位图
+
+typedef struct {
+    uint8_t modifier;
+    uint8_t bitmap[KEYBOARD_REPORT_BITMAP_SIZE];
+    uint8_t slots[KEYBOARD_REPORT_BOOT_KEYS];  // 启动报告键码，按按下顺序排列
+    uint8_t slot_of[0xE0];                     // 键所在槽位 + 1，0 表示不在槽位中
+    uint8_t slot_count;
+    uint8_t key_count;                         // 按住的非修饰键总数（可超过6）
+    bool dirty;                                // 自上次 ClearDirty 以来报告内容有变化
+} KeyboardReport;
+
+void KeyboardReport_Init(KeyboardReport *report);
+
+/**
+ * @brief 按下/释放一个键（0 与 0xE8-0xFF 被忽略）。
+ * @return 报告内容是否变化；已按下的键再按下、未按下的键释放、无效键码都返回false。
+ */
+bool KeyboardReport_AddKey(KeyboardReport *report, uint8_t key_code);
+bool KeyboardReport_RemoveKey(KeyboardReport *report, uint8_t key_code);
+
+/**
+ * @brief 释放全部按键，返回此前是否有键按住。
+ */
+bool KeyboardReport_Clear(KeyboardReport *report);
+
+/**
+ * @brief 把 src 中按住的键也按入 dst。
+ */
+void KeyboardReport_Merge(KeyboardReport *dst, const KeyboardReport *src);
+
+bool KeyboardReport_HasKey(const KeyboardReport *report, uint8_t key_code);
+
+static inline bool KeyboardReport_IsDirty(const KeyboardReport *report) { return report->dirty; }
+static inline void KeyboardReport_MarkDirty(KeyboardReport *report) { report->dirty = true; }
+static inline void KeyboardReport_ClearDirty(KeyboardReport *report) { report->dirty = false; }
+
+/**
+ * @brief 序列化为8字节启动报告；超过6键时6个槽位全部填 ErrorRollOver (0x01)。
+ * @return 报告长度 KEYBOARD_REPORT_BOOT_SIZE。
+ */
+uint16_t KeyboardReport_SerializeBoot(const KeyboardReport *report, uint8_t *out);
+
+/**
+ * @brief 序列化为NKRO报告：report_id、修饰键、位图。
+ * @return 报告长度 KEYBOARD_REPORT_NKRO_SIZE。
+ */
+uint16_t KeyboardReport_SerializeNkro(const KeyboardReport *report, uint8_t report_id, uint8_t *out);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef __LED_MATH_H
+#define __LED_MATH_H
+
+#include "stm32f4xx_hal.h"
+
+// 灯效定点数学：Q15正弦/余弦查表、8位缩放与混合、缓动曲线，全部为整数运算（不用double、不做除法）。
+// 相位为16位，65536 = 一整圈；正弦/余弦为Q15（-32767~32767）；8位值 0~255 表示 0~1。
+
+/**
+ * @brief Q15正弦：四分之一周期64段查表并线性插值，误差不超过 4/32767。
+ */
+int16_t LedMath_Sin16(uint16_t phase);
+
+static inline int16_t LedMath_Cos16(uint16_t phase)
+{
+    return LedMath_Sin16((uint16_t)(phase + 16384U));
+}
+
+/**
+ * @brief 正弦映射到 0~255（相位0时为128，1/4圈时为255）。
+ */
+static inline uint8_t LedMath_Sin8(uint16_t phase)
+{
+    return (uint8_t)((LedMath_Sin16(phase) + 32768) >> 8);
+}
+
+/**
+ * @brief v * scale / 256，scale = 255 时原样返回 v。
+ */
+static inline uint8_t LedMath_Scale8(uint8_t v, uint8_t scale)
+{
+    return (uint8_t)(((uint16_t)v * (1U + scale)) >> 8);
+}
+
+/**
+ * @brief 按同一比例原地缩放 n 个值（如整条GRB缓冲）。
+ */
+void LedMath_NScale8(uint8_t *v, uint16_t n, uint8_t scale);
+
+/**
+ * @brief 从 a 到 b 按 amount 线性混合（amount = 0 为 a，255 为 b）。
+ */
+static inline uint8_t LedMath_Blend8(uint8_t a, uint8_t b, uint8_t amount)
+{
+    return (uint8_t)(LedMath_Scale8(a, (uint8_t)(255U - amount)) + LedMath_Scale8(b, amount));
+}
+
+/**
+ * @brief 缓动曲线（输入输出都是 0~255，两端固定）：二次、三次缓入缓出。
+ */
+static inline uint8_t LedMath_EaseInOutQuad8(uint8_t t)
+{
+    uint8_t j = (t & 0x80U) ? (uint8_t)(255U - t) : t;
+    uint8_t e = LedMath_Scale8(j, j);
+
+    e = (uint8_t)(e << 1);
+    return (t & 0x80U) ? (uint8_t)(255U - e) : e;
+}
+
+static inline uint8_t LedMath_EaseInOutCubic8(uint8_t t)
+{
+    uint32_t t2 = (uint32_t)t * t;
+
+    // 3t^2 - 2t^3，t 按 t/256 计，32位中间量保证单调
+    return (uint8_t)((t2 * (768U - 2U * t)) >> 16);
+}
+
+/**
+ * @brief HSV转RGB，色相为8位（256 = 一整圈），只用乘法和移位。
+ */
+static inline void LedMath_HsvToRgb(uint8_t hue, uint8_t sat, uint8_t val, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+    uint16_t h6 = (uint16_t)hue * 6U;      // 高8位为区间 0~5，低8位为区间内位置
+    uint8_t region = (uint8_t)(h6 >> 8);
+    uint8_t remainder = (uint8_t)h6;
+    uint8_t p = LedMath_Scale8(val, (uint8_t)(255U - sat));
+    uint8_t q = LedMath_Scale8(val, (uint8_t)(255U - LedMath_Scale8(sat, remainder)));
+    uint8_t t = LedMath_Scale8(val, (uint8_t)(255U - LedMath_Scale8(sat, (uint8_t)(255U - remainder))));
+
+    switch (region) {
+        case 0:  *red = val; *green = t;   *blue = p;   break;
+        case 1:  *red = q;   *green = val; *blue = p;   break;
+        case 2:  *red = p;   *green = val; *blue = t;   break;
+        case 3:  *red = p;   *green = q;   *blue = val; break;
+        case 4:  *red = t;   *green = p;   *blue = val; break;
+        default: *red = val; *green = p;   *blue = q;   break;
+    }
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef __MACRO_H
+#define __MACRO_H
+
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+#include "keyboard_report.h"
+
+// 非阻塞宏回放：按下/释放/延时序列或ASCII文本，在主循环中异步推进。
+// 每个USB轮询时隙（IN端点一次DataIn完成）只提交一次按键跳变，与正常打字同时进行：
+// 宏按下的键与矩阵按下的键在报告中按位合并。
+
+// 等不到DataIn（如USB未枚举或被挂起）时，超过该时间也推进一步，避免宏永久卡住
+#define MACRO_SLOT_TIMEOUT_US 8000U
+
+typedef enum {
+    MACRO_END = 0,   // 序列结束，释放宏仍按住的所有键
+    MACRO_PRESS,     // 按下 key_code
+    MACRO_RELEASE,   // 释放 key_code
+    MACRO_TAP,       // 按下并释放 key_code（占两个轮询时隙）
+    MACRO_DELAY      // 等待 delay_ms 毫秒
+} MacroOp;
+
+typedef struct {
+    uint8_t op;        // MacroOp
+    uint8_t key_code;
+    uint16_t delay_ms;
+} MacroStep;
+
+/**
+ * @brief 开始回放以 MACRO_END 结尾的步骤序列（序列须在回放期间保持有效）。
+ * @return 已有宏在回放时返回false。
+ */
+bool Macro_Play(const MacroStep *steps);
+
+/**
+ * @brief 按美式布局逐字符输入ASCII文本，支持 '\n'、'\t'，不可输入的字符被跳过。
+ * @return 已有宏在回放时返回false。
+ */
+bool Macro_PlayText(const char *text);
+
+/**
+ * @brief 立即停止回放；若宏还按着键，由下一次 Macro_Process() 报告全部释放。
+ */
+void Macro_Stop(void);
+
+bool Macro_IsPlaying(void);
+
+/**
+ * @brief 在主循环中调用：轮询时隙空闲（且延时已到）时推进到下一次按键跳变。
+ * @return 宏按键状态有变化，调用者须提交一次合并了 Macro_ApplyToReport() 的报告。
+ */
+bool Macro_Process(uint64_t now_us);
+
+/**
+ * @brief 把宏当前按住的键并入报告。
+ */
+void Macro_ApplyToReport(KeyboardReport *report);
+
+/**
+ * @brief 在USB中断中调用：主机已取走一个键盘报告，下一个轮询时隙可用。
+ */
+void Macro_OnReportSent(void);
+
+#endif
@@ -54,11 +54,20 @@ void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
 void Send_HID_Report(uint8_t keycode);
+void USB_Resume_Callback(void);
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
 
 /* USER CODE BEGIN Private defines */
+/* 中断优先级规划（NVIC_PRIORITYGROUP_4，数值越小越优先；SysTick 为 TICK_INT_PRIORITY = 15）
+ * 各ISR只做有界的短操作，按键数量相关的处理全部放到最低优先级的PendSV下半部，
+ * 因此USB与WS2812的响应延迟不再随按住的按键数变化。 */
+#define IRQ_PRIO_WS2812_DMA   0   /* DMA1_Stream0：WS2812帧发送完成，停止PWM并释放缓冲 */
+#define IRQ_PRIO_USB          1   /* OTG_FS：USB事务处理 */
+#define IRQ_PRIO_MATRIX_SCAN  2   /* TIM3 / DMA2_Stream1 / 列线EXTI：只采集矩阵快照（上半部） */
+#define IRQ_PRIO_WS2812_TIM   3   /* TIM4：WS2812 PWM定时器 */
+#define IRQ_PRIO_MATRIX_BH    15  /* PendSV：消抖、事件生成、长按计时（下半部） */
 
 /* USER CODE END Private defines */
 
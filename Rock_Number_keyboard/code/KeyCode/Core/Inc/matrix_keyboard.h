@@ -5,19 +5,53 @@
 #include <stdbool.h>
 // --- 可配置参数 ---
 
-// 1. 定义行列数量
+// 1. 定义行列数量（可由编译选项覆盖；此时引脚与 Key_Map 须由 MATRIX_EXTERNAL_LAYOUT 提供，见 matrix_keyboard.c）
+#ifndef ROW_NUM
 #define ROW_NUM 5
+#endif
+#ifndef COL_NUM
 #define COL_NUM 4
+#endif
+
+// 按键总数与矩阵位图所需的32位字数（按键索引 k = row * COL_NUM + col）
+#define MATRIX_KEY_NUM (ROW_NUM * COL_NUM)
+#define MATRIX_WORDS   ((MATRIX_KEY_NUM + 31) / 32)
 
 // 2. 定义按键处理时间间隔 (ms)
-#define KEY_SCAN_INTERVAL   10  // 每10ms处理一次按键逻辑，替代HAL_Delay
 #define KEY_DEBOUNCE_TIME   20  // 消抖时间 (ms)
 #define KEY_LONG_PRESS_TIME 700 // 长按初始触发时间 (ms)
 #define KEY_REPEAT_INTERVAL 100 // 长按连发间隔 (ms)
 
-// 3. 定义最大同时按下的按键数
+// 3. 启动协议 (BIOS) 报告最多同时上报的按键数；报告协议下使用NKRO位图，不受此限制
 #define MAX_PRESSED_KEYS    6
 
+// 4. 消抖模式（编译期选择）
+#define DEBOUNCE_SYM_DEFER   0 // 对称延迟：按下与释放都需连续稳定采样后才上报（纵向计数器）
+#define DEBOUNCE_ASYM_EAGER  1 // 急按下：首个按下采样立即上报，锁定后只对释放做延迟消抖（纵向计数器）
+#define DEBOUNCE_EAGER_PK    2 // 逐键急按下：同上，但每键独立8位计数，锁定窗口可超过7ms
+
+#define MATRIX_DEBOUNCE_MODE DEBOUNCE_SYM_DEFER // 上电时的模式；前两种可用 MatrixKeyboard_SetDebounceMode() 运行时切换
+#define KEY_EAGER_LOCKOUT_MS 5 // 急按下模式下，按下/释放上报后忽略抖动的锁定窗口 (ms，1kHz扫描即采样次数)
+
+// 5. 空闲唤醒：所有按键释放超过该时间后停止TIM3扫描，拉高全部行并由列线EXTI唤醒 (ms，0 表示禁用)
+#define KEY_IDLE_TIMEOUT_MS  1000
+
+// 6. 扫描方式：0 = TIM3中断中由CPU逐行扫描（默认1kHz，可用 MatrixKeyboard_SetScanRate() 运行时修改）；
+//    1 = TIM1触发DMA2把行图样写入行端口BSRR、并把列端口IDR采样到环形缓冲，CPU只在半满/全满回调中消抖
+//    （DMA方式要求所有行在同一端口、所有列在同一端口）
+#define MATRIX_SCAN_DMA      0
+#define MATRIX_SCAN_HZ       8000 // DMA方式的整帧扫描频率 (Hz)，须为1000的整数倍；每1ms的多帧合并为一次消抖采样
+#define MATRIX_SCAN_RATE_MIN_HZ 250  // CPU扫描方式运行时可设置的频率范围 (Hz)
+#define MATRIX_SCAN_RATE_MAX_HZ 4000
+
+// 7. 事件队列长度（2的幂，≤128）
+#define MATRIX_EVENT_QUEUE_SIZE 32
+
+// 8. 矩阵增量事件：1 = 按下/释放不再逐键入队，每个扫描周期最多一条 MatrixDelta
+//    （时间戳 + 翻转位图 + 新状态位图）；长按/连发仍走事件队列
+#define MATRIX_DELTA_EVENTS     0
+#define MATRIX_DELTA_QUEUE_SIZE 16 // 增量队列长度（2的幂，≤128）
+
 // --- 公共类型和函数声明 ---
 
 /**
@@ -34,29 +68,38 @@ typedef enum {
  * @brief 按键事件结构体
  */
 typedef struct {
+    uint64_t     timestamp_us; // 检测到该事件的扫描完成时刻 (Timebase_Micros)
     uint8_t      key_code; // 按键的键码 (来自Key_Map)
     uint8_t      row;      // 行索引
     uint8_t      col;      // 列索引
     KeyEventType event;    // 按键的事件类型
 } KeyEvent;
 
+/**
+ * @brief 矩阵增量（MATRIX_DELTA_EVENTS 模式）：按键索引 k = row * COL_NUM + col，
+ *        位于 changed/state 第 k / 32 个字的第 k % 32 位。
+ *        消费者按 state = (state & ~changed) | (新state & changed) 合并。
+ */
+typedef struct {
+    uint64_t timestamp_us;          // 扫描完成时刻 (Timebase_Micros)
+    uint32_t changed[MATRIX_WORDS]; // 相对上一条增量翻转的按键
+    uint32_t state[MATRIX_WORDS];   // 翻转后的消抖按下状态
+} MatrixDelta;
+
 /**
  * @brief 初始化矩阵键盘所需的GPIO
  */
 void MatrixKeyboard_Init(void);
 
 /**
- * @brief 处理矩阵键盘逻辑（应在主循环中被周期性调用）
- * @param p_key_events - 指向用于存储按键事件的缓冲区
- * @param buffer_size  - 缓冲区的最大长度
- * @return uint8_t     - 本次调用检测到的有效按键事件数量
+ * @brief 在TIM中断里调用的扫描步进函数（1kHz上半部）：只采集矩阵快照并挂起PendSV。
  */
-uint8_t MatrixKeyboard_Process(KeyEvent* p_key_events, uint8_t buffer_size);
+void MatrixKeyboard_ScanStep_ISR(void);
 
 /**
- * @brief 在TIM中断里调用的扫描步进函数（1kHz）。
+ * @brief 扫描下半部（在 PendSV_Handler 中调用）：处理积压的快照，完成消抖、事件生成与长按计时。
  */
-void MatrixKeyboard_ScanStep_ISR(void);
+void MatrixKeyboard_BottomHalf_ISR(void);
 
 /**
  * @brief 从事件队列取出一个事件，主循环调用。
@@ -64,4 +107,64 @@ void MatrixKeyboard_ScanStep_ISR(void);
  */
 bool MatrixKeyboard_PopEvent(KeyEvent* out_event);
 
+/**
+ * @brief 从事件队列一次取出最多 max_events 个事件，主循环调用。
+ * @return 实际取出的事件数；缓冲区为 MATRIX_EVENT_QUEUE_SIZE 时一次即可取空队列。
+ */
+uint8_t MatrixKeyboard_PopEvents(KeyEvent* out_events, uint8_t max_events);
+
+/**
+ * @brief 取出一条矩阵增量（MATRIX_DELTA_EVENTS 模式），主循环调用。
+ * @return true 表示取到增量；false 表示队列为空。
+ */
+bool MatrixKeyboard_PopDelta(MatrixDelta* out_delta);
+
+/**
+ * @brief 查询按键映射表中的键码（无效位置返回 0x00）。
+ */
+uint8_t MatrixKeyboard_GetKeyCode(uint8_t row, uint8_t col);
+
+/**
+ * @brief 队列满时被合并（按下/释放，稍后补发）或丢弃（长按/连发）的事件累计数。
+ */
+uint32_t MatrixKeyboard_GetEventOverflows(void);
+
+/**
+ * @brief 列线EXTI回调（在 HAL_GPIO_EXTI_Callback 中调用），空闲时恢复TIM3扫描。
+ */
+void MatrixKeyboard_EXTI_ISR(uint16_t GPIO_Pin);
+
+/**
+ * @brief 不等超时立即进入空闲（如USB挂起时），之后只能由列线EXTI唤醒。
+ * @return 已进入空闲；有键按住（无法产生唤醒边沿）或未启用空闲唤醒时返回false，扫描继续。
+ */
+bool MatrixKeyboard_Sleep(void);
+
+/**
+ * @brief 是否处于空闲状态（TIM3已停止，等待列线唤醒）。
+ */
+bool MatrixKeyboard_IsIdle(void);
+
+/**
+ * @brief 运行时切换消抖模式，在下一次消抖采样时生效，进行中的计数清零。
+ *        DEBOUNCE_SYM_DEFER 与 DEBOUNCE_ASYM_EAGER 共用纵向计数器，可互相切换；
+ *        DEBOUNCE_EAGER_PK 的逐键计数只能在编译期选择。
+ * @return 当前编译配置不支持该模式时返回false。
+ */
+bool MatrixKeyboard_SetDebounceMode(uint8_t mode);
+uint8_t MatrixKeyboard_GetDebounceMode(void);
+
+/**
+ * @brief 运行时修改CPU扫描频率（MATRIX_SCAN_RATE_MIN_HZ..MATRIX_SCAN_RATE_MAX_HZ）。
+ *        长按、连发与空闲超时仍按ms计时；消抖按采样次数计，消抖时间随频率缩放。
+ * @return 超出范围或DMA扫描方式（频率由 MATRIX_SCAN_HZ 固定）时返回false。
+ */
+bool MatrixKeyboard_SetScanRate(uint16_t hz);
+uint16_t MatrixKeyboard_GetScanRate(void);
+
+/**
+ * @brief 下半部积压导致丢弃的扫描快照累计数。
+ */
+uint32_t MatrixKeyboard_GetScanOverruns(void);
+
 #endif // __MATRIX_KEYBOARD_H
\ No newline at end of file
@@ -58,6 +58,7 @@ void SysTick_Handler(void);
 void TIM3_IRQHandler(void);
 void TIM4_IRQHandler(void);
 void OTG_FS_IRQHandler(void);
+void OTG_FS_WKUP_IRQHandler(void);
 /* USER CODE BEGIN EFP */
 
 /* USER CODE END EFP */
@@ -29,6 +29,8 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
+#include "matrix_keyboard.h"
+#include "ws2812.h"
 
 /* USER CODE END Includes */
 
@@ -37,6 +39,9 @@ extern TIM_HandleTypeDef htim3;
 extern TIM_HandleTypeDef htim4;
 
 /* USER CODE BEGIN Private defines */
+#if (MATRIX_SCAN_DMA)
+extern TIM_HandleTypeDef htim1;
+#endif
 
 /* USER CODE END Private defines */
 
@@ -46,6 +51,9 @@ void MX_TIM4_Init(void);
 void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
 /* USER CODE BEGIN Prototypes */
+#if (MATRIX_SCAN_DMA)
+void MX_TIM1_Init(void);
+#endif
 
 /* USER CODE END Prototypes */
 
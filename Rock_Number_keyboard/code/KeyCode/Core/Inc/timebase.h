@@ -0,0 +1,29 @@
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#include "stm32f4xx_hal.h"
+
+// 统一的64位单调时间基准：DWT CYCCNT（168MHz下约25.6s回绕一次）在软件中扩展为64位。
+// 任意上下文都可调用；SysTick中的 Timebase_Poll() 保证每次回绕都能被看到。
+
+/**
+ * @brief 使能DWT周期计数器，须在 SystemClock_Config() 之后调用。
+ */
+void Timebase_Init(void);
+
+/**
+ * @brief 64位CPU周期计数。
+ */
+uint64_t Timebase_Cycles(void);
+
+/**
+ * @brief 64位微秒计数（自 Timebase_Init() 起）。
+ */
+uint64_t Timebase_Micros(void);
+
+/**
+ * @brief 在SysTick中调用，跟踪32位计数器回绕。
+ */
+void Timebase_Poll(void);
+
+#endif
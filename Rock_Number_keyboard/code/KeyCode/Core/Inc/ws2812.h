@@ -5,6 +5,27 @@
 
 #define WS2812_LED_NUM 20  // 根据实际LED数量调整
 
+// DMA发送方式：0 = 整帧编码到DMA缓冲区后一次发送（缓冲区随LED数量增长，每个LED 48字节）；
+//              1 = 流式发送：DMA循环发送只含 WS2812_STREAM_LEDS 个LED的乒乓缓冲区，每发完一半，
+//                  在半满/全满中断中编码下一组LED填入，DMA内存与LED数量无关（默认96字节），
+//                  代价是发送期间每组LED一次中断
+//              两项均可由编译选项覆盖（主机测试分别编译两种方式）
+#ifndef WS2812_DMA_STREAM
+#define WS2812_DMA_STREAM   0
+#endif
+#ifndef WS2812_STREAM_LEDS
+#define WS2812_STREAM_LEDS  2  // 乒乓缓冲区的LED数（偶数）
+#endif
+
+// 灯效帧调度：SysTick中按固定帧率置位，主循环中的 WS2812_ProcessEffects() 每帧绘制一次，
+// 只有帧缓冲被改写（或锁定键状态变化）时才编码并发送
+#define WS2812_FRAME_RATE_HZ   100   // 帧率 (Hz，1~1000)
+#define WS2812_FRAME_BUDGET_US 1000  // 每帧绘制+编码的CPU预算 (us)，超出时跳过随后的帧
+
+// 主机锁定键指示：Num Lock 打开时，Num Lock 键（ROW0, COL0）下的LED显示指示色
+#define WS2812_NUM_LOCK_LED  0
+#define WS2812_LOCK_NUM      0x01  // 与HID LED输出报告的位定义一致
+
 // 背光模式枚举
 typedef enum {
     WS2812_MODE_OFF = 0,        // 关闭
@@ -35,10 +56,15 @@ extern const WS2812_Color WS2812_COLOR_OFF;
 
 // 基础函数
 void WS2812_Init(void);
-void WS2812_SetColor(uint8_t led_index, uint8_t red, uint8_t green, uint8_t blue);
-void WS2812_SetColorStruct(uint8_t led_index, WS2812_Color color);
-void WS2812_Update(void);
+void WS2812_SetColor(uint16_t led_index, uint8_t red, uint8_t green, uint8_t blue);
+void WS2812_SetColorStruct(uint16_t led_index, WS2812_Color color);
+// 提交当前绘制的帧：DMA空闲时立即开始发送，否则排队，在当前帧发送完成时由DMA中断接着发送。
+// 排队期间再次提交时只保留最新一帧（被替换的帧计入丢弃数）；提交后可立即继续绘制下一帧
+void WS2812_Present(void);
+void WS2812_Update(void);  // 同 WS2812_Present()
 void WS2812_DMAComplete(void);
+uint32_t WS2812_GetPresentedFrames(void);  // 已开始发送的帧数
+uint32_t WS2812_GetDroppedFrames(void);    // 发送前被更新的帧替换掉的帧数
 
 // 模式管理函数
 void WS2812_SetMode(WS2812_Mode mode);
@@ -50,7 +76,18 @@ uint8_t WS2812_GetBrightness(void);
 // 效果函数
 void WS2812_ClearAll(void);
 void WS2812_SetAll(WS2812_Color color);
-void WS2812_ProcessEffects(void);  // 在主循环中调用以更新动态效果
+void WS2812_ProcessEffects(void);  // 在主循环中调用：到帧时刻时推进动态效果，帧缓冲有变化才提交
+void WS2812_FrameTick(void);       // 在SysTick中断中调用（1kHz），按 WS2812_FRAME_RATE_HZ 产生帧时刻
+uint32_t WS2812_GetEffectTimeUs(void);     // 灯效累计CPU时间 (us，绘制 + 编码 + 提交)
+uint32_t WS2812_GetEffectMaxUs(void);      // 单帧最长CPU时间 (us)
+uint32_t WS2812_GetOverBudgetFrames(void); // 超出 WS2812_FRAME_BUDGET_US 的帧数
+
+// USB挂起：熄灭全部LED并等待该帧发送完成（此后TIM4停止）；恢复时按当前模式重绘
+void WS2812_Suspend(void);
+void WS2812_Resume(void);
+
+// 锁定键指示（可在USB中断中调用，下一次 WS2812_ProcessEffects() 即刷新）
+void WS2812_SetLockIndicators(uint8_t leds);
 
 // 按键响应函数
 void WS2812_OnKeyPress(uint8_t row, uint8_t col);
@@ -0,0 +1,256 @@
+#include "console.h"
+
+#if (USBD_CDC_CONSOLE == 1U)
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "usbd_cdc_console.h"
+#include "matrix_keyboard.h"
+
+#if (CONSOLE_TX_SIZE & (CONSOLE_TX_SIZE - 1U)) != 0U || (CONSOLE_RX_SIZE & (CONSOLE_RX_SIZE - 1U)) != 0U
+#error "CONSOLE_TX_SIZE and CONSOLE_RX_SIZE must be powers of two"
+#endif
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+// ---- 发送环（多生产者：主循环与任意中断；单消费者：USB中断） ----
+// 生产者用CAS预留空间后写入，不关中断。单核上抢占严格嵌套：被抢占的写入者恢复前，
+// 抢占它的写入者一定已经写完，因此最外层写入者退出时（s_tx_writers 归零）发布全部已预留的数据。
+static uint8_t s_tx_buf[CONSOLE_TX_SIZE];
+static volatile uint32_t s_tx_reserve = 0;  // 已预留到的位置
+static volatile uint32_t s_tx_commit = 0;   // 已写完、可发送到的位置
+static volatile uint32_t s_tx_tail = 0;     // USB中断已取走到的位置
+static volatile uint32_t s_tx_writers = 0;  // 正在写入的生产者数
+static volatile uint32_t s_tx_dropped = 0;
+
+// ---- 接收环（单生产者：USB中断；单消费者：主循环） ----
+static uint8_t s_rx_buf[CONSOLE_RX_SIZE];
+static volatile uint32_t s_rx_head = 0;
+static volatile uint32_t s_rx_tail = 0;
+
+static char s_line[CONSOLE_LINE_SIZE];
+static uint8_t s_line_len = 0;
+static char s_line_last = 0;  // 上一个收到的字符，用于合并 "\r\n"
+
+static const struct {
+    const char *name;
+    uint8_t mode;
+} s_debounce_names[] = {
+    { "sym",   DEBOUNCE_SYM_DEFER },
+    { "eager", DEBOUNCE_ASYM_EAGER },
+    { "pk",    DEBOUNCE_EAGER_PK },
+};
+
+// 最外层写入者退出时发布；期间抢占的写入者可能已发布到更新的位置，只向前推进
+static void Console_TxRelease(void)
+{
+    uint32_t reserve;
+    uint32_t commit;
+
+    if (__atomic_sub_fetch(&s_tx_writers, 1U, __ATOMIC_RELEASE) != 0U) return;
+
+    reserve = __atomic_load_n(&s_tx_reserve, __ATOMIC_ACQUIRE);
+    commit = __atomic_load_n(&s_tx_commit, __ATOMIC_RELAXED);
+    while ((int32_t)(reserve - commit) > 0 &&
+           !__atomic_compare_exchange_n(&s_tx_commit, &commit, reserve, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+}
+
+void Console_Write(const char *data, uint16_t len)
+{
+    uint32_t start;
+    uint32_t first;
+
+    if (len == 0U) return;
+
+    __atomic_add_fetch(&s_tx_writers, 1U, __ATOMIC_ACQUIRE);
+
+    start = __atomic_load_n(&s_tx_reserve, __ATOMIC_RELAXED);
+    do {
+        if (CONSOLE_TX_SIZE - (start - s_tx_tail) < len) {
+            __atomic_add_fetch(&s_tx_dropped, len, __ATOMIC_RELAXED);
+            Console_TxRelease();
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&s_tx_reserve, &start, start + len, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    first = CONSOLE_TX_SIZE - (start & (CONSOLE_TX_SIZE - 1U));
+    if (first > len) first = len;
+    memcpy(&s_tx_buf[start & (CONSOLE_TX_SIZE - 1U)], data, first);
+    memcpy(s_tx_buf, data + first, len - first);
+
+    Console_TxRelease();
+}
+
+void Console_Print(const char *str)
+{
+    Console_Write(str, (uint16_t)strlen(str));
+}
+
+void Console_Printf(const char *fmt, ...)
+{
+    char buf[CONSOLE_PRINTF_SIZE];
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (len <= 0) return;
+    if (len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
+    Console_Write(buf, (uint16_t)len);
+}
+
+uint32_t Console_GetDropped(void)
+{
+    return s_tx_dropped;
+}
+
+// USB中断：取出最多max字节装载到批量IN端点
+uint16_t USBD_CDC_Console_TxFill(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t max)
+{
+    uint32_t tail = s_tx_tail;
+    uint32_t avail = __atomic_load_n(&s_tx_commit, __ATOMIC_ACQUIRE) - tail;
+    uint32_t first;
+    uint16_t len;
+
+    (void)pdev;
+    len = (uint16_t)((avail < max) ? avail : max);
+    if (len == 0U) return 0;
+
+    first = CONSOLE_TX_SIZE - (tail & (CONSOLE_TX_SIZE - 1U));
+    if (first > len) first = len;
+    memcpy(buf, &s_tx_buf[tail & (CONSOLE_TX_SIZE - 1U)], first);
+    memcpy(buf + first, s_tx_buf, len - first);
+
+    __atomic_store_n(&s_tx_tail, tail + len, __ATOMIC_RELEASE);
+    return len;
+}
+
+// USB中断：收到的字符放入接收环，环满时丢弃
+void USBD_CDC_Console_Received(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t len)
+{
+    uint32_t head = s_rx_head;
+
+    (void)pdev;
+    for (uint16_t i = 0; i < len && (head - s_rx_tail) < CONSOLE_RX_SIZE; i++) {
+        s_rx_buf[head++ & (CONSOLE_RX_SIZE - 1U)] = buf[i];
+    }
+    __DMB(); // 数据先于写指针可见
+    s_rx_head = head;
+}
+
+__weak void Console_AppStats(void)
+{
+}
+
+static const char *Console_DebounceName(uint8_t mode)
+{
+    for (uint8_t i = 0; i < sizeof(s_debounce_names) / sizeof(s_debounce_names[0]); i++) {
+        if (s_debounce_names[i].mode == mode) return s_debounce_names[i].name;
+    }
+    return "?";
+}
+
+static void Console_Stats(void)
+{
+    Console_Printf("scan: %u Hz, debounce %s, overruns %lu, event overflows %lu\r\n",
+                   MatrixKeyboard_GetScanRate(), Console_DebounceName(MatrixKeyboard_GetDebounceMode()),
+                   (unsigned long)MatrixKeyboard_GetScanOverruns(),
+                   (unsigned long)MatrixKeyboard_GetEventOverflows());
+    Console_Printf("usb: state %u, protocol %s, leds 0x%02X\r\n", hUsbDeviceFS.dev_state,
+                   (USBD_HID_GetProtocol(&hUsbDeviceFS) == HID_PROTOCOL_BOOT) ? "boot" : "report",
+                   USBD_HID_GetLedState(&hUsbDeviceFS));
+    Console_AppStats();
+    Console_Printf("console: %lu bytes dropped\r\n", (unsigned long)s_tx_dropped);
+}
+
+static void Console_Scan(const char *arg)
+{
+    if (arg != NULL && !MatrixKeyboard_SetScanRate((uint16_t)strtoul(arg, NULL, 10))) {
+        Console_Printf("scan rate must be %u..%u Hz (CPU scan only)\r\n",
+                       MATRIX_SCAN_RATE_MIN_HZ, MATRIX_SCAN_RATE_MAX_HZ);
+        return;
+    }
+    Console_Printf("scan: %u Hz\r\n", MatrixKeyboard_GetScanRate());
+}
+
+static void Console_Debounce(const char *arg)
+{
+    if (arg != NULL) {
+        uint8_t i = 0;
+
+        while (i < sizeof(s_debounce_names) / sizeof(s_debounce_names[0]) &&
+               strcmp(arg, s_debounce_names[i].name) != 0) {
+            i++;
+        }
+        if (i == sizeof(s_debounce_names) / sizeof(s_debounce_names[0]) ||
+            !MatrixKeyboard_SetDebounceMode(s_debounce_names[i].mode)) {
+            Console_Print("debounce mode not available in this build\r\n");
+            return;
+        }
+    }
+    Console_Printf("debounce: %s\r\n", Console_DebounceName(MatrixKeyboard_GetDebounceMode()));
+}
+
+static void Console_Execute(char *line)
+{
+    char *arg = strchr(line, ' ');
+
+    if (arg != NULL) {
+        *arg++ = '\0';
+        while (*arg == ' ') arg++;
+        if (*arg == '\0') arg = NULL;
+    }
+
+    if (line[0] == '\0') {
+        return;
+    } else if (strcmp(line, "stats") == 0) {
+        Console_Stats();
+    } else if (strcmp(line, "scan") == 0) {
+        Console_Scan(arg);
+    } else if (strcmp(line, "debounce") == 0) {
+        Console_Debounce(arg);
+    } else if (strcmp(line, "help") == 0) {
+        Console_Print("stats                    counters and latencies\r\n"
+                      "scan [hz]                show or set the matrix scan rate\r\n"
+                      "debounce [sym|eager|pk]  show or set the debounce mode\r\n");
+    } else {
+        Console_Printf("unknown command '%s', try help\r\n", line);
+    }
+}
+
+void Console_Process(void)
+{
+    while (s_rx_tail != s_rx_head) {
+        __DMB(); // 先看到写指针，再读数据
+        char c = (char)s_rx_buf[s_rx_tail & (CONSOLE_RX_SIZE - 1U)];
+        char last = s_line_last;
+        s_rx_tail++;
+        s_line_last = c;
+
+        if (c == '\r' || c == '\n') {
+            if (c == '\n' && last == '\r') continue;
+            Console_Print("\r\n");
+            s_line[s_line_len] = '\0';
+            Console_Execute(s_line);
+            s_line_len = 0;
+            Console_Print("> ");
+        } else if (c == '\b' || c == 0x7F) {
+            if (s_line_len > 0U) {
+                s_line_len--;
+                Console_Print("\b \b");
+            }
+        } else if (c >= 0x20 && c < 0x7F && s_line_len < CONSOLE_LINE_SIZE - 1U) {
+            s_line[s_line_len++] = c;
+            Console_Write(&c, 1);
+        }
+    }
+}
+
+#endif // USBD_CDC_CONSOLE
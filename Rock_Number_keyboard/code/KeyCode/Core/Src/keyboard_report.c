@@ -0,0 +1,153 @@
+#include "keyboard_report.h"
+#include <string.h>
+
+#define KEY_ERROR_ROLLOVER 0x01U
+#define KEY_MODIFIER_FIRST 0xE0U
+#define KEY_MODIFIER_LAST  0xE7U  // 更大的键码不是键盘用法，不能按低3位当作修饰键
+
+void KeyboardReport_Init(KeyboardReport *report)
+{
+    memset(report, 0, sizeof(*report));
+}
+
+bool KeyboardReport_HasKey(const KeyboardReport *report, uint8_t key_code)
+{
+    uint8_t mask = (uint8_t)(1U << (key_code & 0x07));
+
+    if (key_code > KEY_MODIFIER_LAST) return false;
+    if (key_code >= KEY_MODIFIER_FIRST) return (report->modifier & mask) != 0U;
+    return (report->bitmap[key_code >> 3] & mask) != 0U;
+}
+
+// 把一个已按下但不在槽位中的键放入末尾槽位
+static void KeyboardReport_Slot(KeyboardReport *report, uint8_t key_code)
+{
+    report->slots[report->slot_count] = key_code;
+    report->slot_of[key_code] = ++report->slot_count;
+}
+
+// 找一个已按下但不在槽位中的键（只在超过6键后释放槽位中的键时调用）
+static uint8_t KeyboardReport_FindUnslotted(const KeyboardReport *report)
+{
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_BITMAP_SIZE; i++) {
+        uint32_t bits = report->bitmap[i];
+
+        while (bits != 0U) {
+            uint8_t key_code = (uint8_t)((i << 3) + __builtin_ctz(bits));
+
+            if (report->slot_of[key_code] == 0U) return key_code;
+            bits &= bits - 1U;
+        }
+    }
+    return 0;
+}
+
+bool KeyboardReport_AddKey(KeyboardReport *report, uint8_t key_code)
+{
+    uint8_t mask = (uint8_t)(1U << (key_code & 0x07));
+
+    if (key_code == 0U || key_code > KEY_MODIFIER_LAST) return false;
+
+    if (key_code >= KEY_MODIFIER_FIRST) {
+        if (report->modifier & mask) return false;
+        report->modifier |= mask;
+    } else {
+        if (report->bitmap[key_code >> 3] & mask) return false;
+        report->bitmap[key_code >> 3] |= mask;
+        report->key_count++;
+        if (report->slot_count < KEYBOARD_REPORT_BOOT_KEYS) {
+            KeyboardReport_Slot(report, key_code);
+        }
+    }
+    report->dirty = true;
+    return true;
+}
+
+bool KeyboardReport_RemoveKey(KeyboardReport *report, uint8_t key_code)
+{
+    uint8_t mask = (uint8_t)(1U << (key_code & 0x07));
+
+    if (key_code == 0U || key_code > KEY_MODIFIER_LAST) return false;
+
+    if (key_code >= KEY_MODIFIER_FIRST) {
+        if (!(report->modifier & mask)) return false;
+        report->modifier &= (uint8_t)~mask;
+    } else {
+        uint8_t slot = report->slot_of[key_code];
+
+        if (!(report->bitmap[key_code >> 3] & mask)) return false;
+        report->bitmap[key_code >> 3] &= (uint8_t)~mask;
+        report->key_count--;
+
+        if (slot != 0U) {
+            // 后面的键前移一格，保持按下顺序（最多移动5个）
+            report->slot_of[key_code] = 0;
+            for (uint8_t i = slot; i < report->slot_count; i++) {
+                report->slots[i - 1U] = report->slots[i];
+                report->slot_of[report->slots[i]] = i;
+            }
+            report->slots[--report->slot_count] = 0;
+
+            // 之前溢出的键补上空出的槽位
+            if (report->key_count > report->slot_count) {
+                KeyboardReport_Slot(report, KeyboardReport_FindUnslotted(report));
+            }
+        }
+    }
+    report->dirty = true;
+    return true;
+}
+
+bool KeyboardReport_Clear(KeyboardReport *report)
+{
+    bool held = (report->modifier != 0U) || (report->key_count != 0U);
+
+    for (uint8_t i = 0; i < report->slot_count; i++) {
+        report->slot_of[report->slots[i]] = 0;
+    }
+    report->modifier = 0;
+    memset(report->bitmap, 0, sizeof(report->bitmap));
+    memset(report->slots, 0, sizeof(report->slots));
+    report->slot_count = 0;
+    report->key_count = 0;
+    if (held) report->dirty = true;
+    return held;
+}
+
+void KeyboardReport_Merge(KeyboardReport *dst, const KeyboardReport *src)
+{
+    if (src->modifier & (uint8_t)~dst->modifier) {
+        dst->modifier |= src->modifier;
+        dst->dirty = true;
+    }
+    if (src->key_count == 0U) return;
+
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_BITMAP_SIZE; i++) {
+        uint32_t bits = src->bitmap[i] & (uint8_t)~dst->bitmap[i];
+
+        while (bits != 0U) {
+            KeyboardReport_AddKey(dst, (uint8_t)((i << 3) + __builtin_ctz(bits)));
+            bits &= bits - 1U;
+        }
+    }
+}
+
+uint16_t KeyboardReport_SerializeBoot(const KeyboardReport *report, uint8_t *out)
+{
+    out[0] = report->modifier;
+    out[1] = 0;
+    if (report->key_count > KEYBOARD_REPORT_BOOT_KEYS) {
+        memset(&out[2], KEY_ERROR_ROLLOVER, KEYBOARD_REPORT_BOOT_KEYS);
+    } else {
+        memcpy(&out[2], report->slots, KEYBOARD_REPORT_BOOT_KEYS);
+    }
+    return KEYBOARD_REPORT_BOOT_SIZE;
+}
+
+uint16_t KeyboardReport_SerializeNkro(const KeyboardReport *report, uint8_t report_id, uint8_t *out)
+{
+    out[0] = report_id;
+    out[1] = report->modifier;
+    memcpy(&out[2], report->bitmap, KEYBOARD_REPORT_BITMAP_SIZE);
+    return KEYBOARD_REPORT_NKRO_SIZE;
+}
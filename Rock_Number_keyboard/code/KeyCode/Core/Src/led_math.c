@@ -0,0 +1,40 @@
+#include "led_math.h"
+
+// 四分之一周期正弦，64段（Q15，最后一项为 sin(pi/2)）
+static const int16_t s_sin_quarter[65] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767,
+};
+
+int16_t LedMath_Sin16(uint16_t phase)
+{
+    uint16_t x = phase & 0x3FFFU;          // 象限内位置，14位
+    uint16_t idx;
+    uint16_t frac;
+    int32_t a;
+    int32_t b;
+    int16_t y;
+
+    if (phase & 0x4000U) x = (uint16_t)(0x4000U - x);  // 第二、四象限镜像
+    idx = x >> 8;
+    frac = x & 0xFFU;
+    a = s_sin_quarter[idx];
+    b = (idx < 64U) ? s_sin_quarter[idx + 1U] : a;
+    y = (int16_t)(a + (((b - a) * (int32_t)frac) >> 8));
+
+    return (phase & 0x8000U) ? (int16_t)-y : y;
+}
+
+void LedMath_NScale8(uint8_t *v, uint16_t n, uint8_t scale)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        v[i] = LedMath_Scale8(v[i], scale);
+    }
+}
@@ -0,0 +1,185 @@
+#include "macro.h"
+
+#define MACRO_KEY_LEFT_SHIFT 0xE1U
+#define MACRO_USAGE_SHIFT    0x80U  // 字符表中的“需要Shift”标志
+
+// ASCII 0x20-0x7E 到HID用法（美式布局），最高位表示需要同时按下左Shift
+static const uint8_t s_ascii_usage[0x7F - 0x20] = {
+    0x2C, 0x9E, 0xB4, 0xA0, 0xA1, 0xA2, 0xA4, 0x34,  //   ! " # $ % & '
+    0xA6, 0xA7, 0xA5, 0xAE, 0x36, 0x2D, 0x37, 0x38,  // ( ) * + , - . /
+    0x27, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24,  // 0 1 2 3 4 5 6 7
+    0x25, 0x26, 0xB3, 0x33, 0xB6, 0x2E, 0xB7, 0xB8,  // 8 9 : ; < = > ?
+    0x9F, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A,  // @ A B C D E F G
+    0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x91, 0x92,  // H I J K L M N O
+    0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A,  // P Q R S T U V W
+    0x9B, 0x9C, 0x9D, 0x2F, 0x31, 0x30, 0xA3, 0xAD,  // X Y Z [ \ ] ^ _
+    0x35, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,  // ` a b c d e f g
+    0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,  // h i j k l m n o
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A,  // p q r s t u v w
+    0x1B, 0x1C, 0x1D, 0xAF, 0xB1, 0xB0, 0xB5,        // x y z { | } ~
+};
+
+static const MacroStep *s_steps = NULL;
+static const char *s_text = NULL;
+static bool s_playing = false;
+static uint8_t s_phase = 0;             // TAP/字符：0 待按下，1 待释放
+static uint64_t s_delay_until_us = 0;
+
+// 宏当前按住的键，与矩阵状态在提交报告时按位合并
+static KeyboardReport s_keys;
+
+// 轮询时隙：提交一次跳变后置false，USB中断在主机取走报告后置true
+static volatile bool s_slot_free = true;
+static uint64_t s_slot_taken_us = 0;
+
+// 按键状态真的变化时才返回true（已按下的键再按下不占用轮询时隙）
+static bool Macro_SetKey(uint8_t key_code)
+{
+    return KeyboardReport_AddKey(&s_keys, key_code);
+}
+
+static bool Macro_ClearKey(uint8_t key_code)
+{
+    return KeyboardReport_RemoveKey(&s_keys, key_code);
+}
+
+static bool Macro_ReleaseAll(void)
+{
+    return KeyboardReport_Clear(&s_keys);
+}
+
+static uint8_t Macro_AsciiToUsage(char c)
+{
+    if (c == '\n') return 0x28; // Enter
+    if (c == '\t') return 0x2B; // Tab
+    if (c < 0x20 || c > 0x7E) return 0;
+    return s_ascii_usage[c - 0x20];
+}
+
+// 文本：每个字符占两个时隙（按下含Shift，再全部释放），相同字符连续出现也能被主机区分
+static bool Macro_AdvanceText(void)
+{
+    while (*s_text != '\0') {
+        uint8_t usage = Macro_AsciiToUsage(*s_text);
+
+        if (usage == 0) {
+            s_text++;
+            continue;
+        }
+        if (s_phase == 0) {
+            if (usage & MACRO_USAGE_SHIFT) Macro_SetKey(MACRO_KEY_LEFT_SHIFT);
+            Macro_SetKey(usage & (uint8_t)~MACRO_USAGE_SHIFT);
+            s_phase = 1;
+        } else {
+            Macro_ClearKey(MACRO_KEY_LEFT_SHIFT);
+            Macro_ClearKey(usage & (uint8_t)~MACRO_USAGE_SHIFT);
+            s_phase = 0;
+            s_text++;
+        }
+        return true;
+    }
+    s_playing = false;
+    return false;
+}
+
+// 步骤序列：执行到下一次按键状态变化、延时或序列结束为止
+static bool Macro_AdvanceSteps(uint64_t now_us)
+{
+    for (;;) {
+        const MacroStep *step = s_steps;
+
+        switch (step->op) {
+        case MACRO_PRESS:
+            s_steps++;
+            if (Macro_SetKey(step->key_code)) return true;
+            break;
+        case MACRO_RELEASE:
+            s_steps++;
+            if (Macro_ClearKey(step->key_code)) return true;
+            break;
+        case MACRO_TAP:
+            if (s_phase == 0) {
+                s_phase = 1;
+                if (Macro_SetKey(step->key_code)) return true;
+            } else {
+                s_phase = 0;
+                s_steps++;
+                if (Macro_ClearKey(step->key_code)) return true;
+            }
+            break;
+        case MACRO_DELAY:
+            s_steps++;
+            s_delay_until_us = now_us + (uint64_t)step->delay_ms * 1000U;
+            return false;
+        default:
+            s_playing = false;
+            return false;
+        }
+    }
+}
+
+static bool Macro_Start(const MacroStep *steps, const char *text)
+{
+    if (s_playing) return false;
+
+    s_steps = steps;
+    s_text = text;
+    s_phase = 0;
+    s_delay_until_us = 0;
+    s_playing = true;
+    return true;
+}
+
+bool Macro_Play(const MacroStep *steps)
+{
+    return (steps != NULL) && Macro_Start(steps, NULL);
+}
+
+bool Macro_PlayText(const char *text)
+{
+    return (text != NULL) && Macro_Start(NULL, text);
+}
+
+void Macro_Stop(void)
+{
+    s_playing = false;
+}
+
+bool Macro_IsPlaying(void)
+{
+    return s_playing;
+}
+
+bool Macro_Process(uint64_t now_us)
+{
+    bool changed;
+
+    if (!s_slot_free && (now_us - s_slot_taken_us) < MACRO_SLOT_TIMEOUT_US) return false;
+    if (now_us < s_delay_until_us) return false;
+
+    if (s_playing) {
+        changed = (s_text != NULL) ? Macro_AdvanceText() : Macro_AdvanceSteps(now_us);
+    } else {
+        changed = false;
+    }
+    // 序列结束或被停止：报告释放宏仍按住的键
+    if (!s_playing) {
+        changed = Macro_ReleaseAll() || changed;
+    }
+
+    if (changed) {
+        s_slot_free = false;
+        s_slot_taken_us = now_us;
+    }
+    return changed;
+}
+
+void Macro_ApplyToReport(KeyboardReport *report)
+{
+    KeyboardReport_Merge(report, &s_keys);
+}
+
+void Macro_OnReportSent(void)
+{
+    s_slot_free = true;
+}
@@ -22,6 +22,10 @@
 #include "usb_device.h"
 #include "gpio.h"
 #include "ws2812.h"
+#include "timebase.h"
+#include "keyboard_report.h"
+#include "macro.h"
+#include "console.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
@@ -50,29 +54,114 @@
 
 /* USER CODE BEGIN PV */
 extern USBD_HandleTypeDef hUsbDeviceFS;
-// HID报告结构体（兼容标准键盘）
-#pragma pack(push, 1)
-typedef struct {
-    uint8_t modifier;   // 修饰键
-    uint8_t reserved;   // 保留
-    uint8_t keycode[6]; // 最多6键
-} HID_KeyboardReport;
-#pragma pack(pop)
-
-// 添加键盘报告变量
-static HID_KeyboardReport keyboard_report;
-
-// 发送HID报告
-void Send_HID_Report(uint8_t keycode) {
-    HID_KeyboardReport report = {0};
+extern PCD_HandleTypeDef hpcd_USB_OTG_FS;
+
+// 键盘状态（增量维护），发送时按主机选择的协议序列化
+static KeyboardReport keyboard_report;
+
+// HID报告入队时间戳，以及报告中最早一个按键变化从扫描检测到入队的延迟 (us)
+// 入队后由SOF/DataIn按主机轮询（1ms）逐个装载到IN端点
+static uint64_t hid_report_submit_us = 0;
+static uint32_t hid_scan_to_usb_us = 0;
+static uint32_t hid_scan_to_usb_max_us = 0;
+
+// 尚未入队的报告变化中最早的按键变化时刻
+static uint64_t report_event_us = 0;
+
+// USB挂起/恢复：远程唤醒信号保持时间（规范要求 1~15ms）
+#define USB_REMOTE_WAKEUP_US 5000U
+static bool usb_suspended = false;          // 已按挂起处理（背光已熄灭）
+static bool usb_wakeup_request = false;     // 挂起期间有按键按下
+static uint64_t usb_wakeup_signal_us = 0;   // 远程唤醒信号开始时刻，0 表示未在发送
+static volatile bool usb_wakeup_sent = false;   // 本次挂起中已发出远程唤醒信号
+static volatile bool usb_report_held = false;   // 本次挂起中有报告入队，等待恢复后发送
+// 总线恢复到主机取走第一个键盘报告的延迟 (us)，用于评估唤醒响应
+// 恢复时刻在USB恢复中断中记录；只在远程唤醒或恢复时已有报告待发送时计时，
+// 主机主动恢复且没有按键时不计入
+static volatile uint64_t usb_resume_us = 0;
+static volatile bool usb_resume_pending = false;
+static uint32_t usb_resume_to_report_us = 0;
+static uint32_t usb_resume_to_report_max_us = 0;
+
+// 按主机选择的协议生成待发送的报告，返回报告长度，*itf 为发送所用的HID接口
+// 报告协议：NKRO报告走接口1；启动协议：标准启动报告走接口0
+// （带CDC控制台的版本没有NKRO接口，始终在接口0发送启动报告）
+static uint16_t Encode_Report(const KeyboardReport *report, uint8_t *out, uint8_t *itf) {
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+    if (USBD_HID_GetProtocol(&hUsbDeviceFS) != HID_PROTOCOL_BOOT) {
+        *itf = HID_ITF_EXTRA;
+        return KeyboardReport_SerializeNkro(report, HID_REPORT_ID_NKRO, out);
+    }
+#endif
+    *itf = HID_ITF_KEYBOARD;
+    return KeyboardReport_SerializeBoot(report, out);
+}
+
+// 按下/释放一个键；报告由无变化变为有变化时记下该按键时刻
+static void Report_Key(uint8_t key_code, bool pressed, uint64_t event_us) {
+    bool was_dirty = KeyboardReport_IsDirty(&keyboard_report);
+    bool changed = pressed ? KeyboardReport_AddKey(&keyboard_report, key_code)
+                           : KeyboardReport_RemoveKey(&keyboard_report, key_code);
+
+    if (changed && !was_dirty) report_event_us = event_us;
+    if (changed && pressed && hUsbDeviceFS.dev_state == USBD_STATE_SUSPENDED) {
+        usb_wakeup_request = true;
+    }
+}
+
+// 报告以外的原因（协议切换、宏回放）需要重新提交报告
+static void Report_Touch(uint64_t event_us) {
+    if (!KeyboardReport_IsDirty(&keyboard_report)) {
+        report_event_us = event_us;
+        KeyboardReport_MarkDirty(&keyboard_report);
+    }
+}
 
-    if (keycode != 0) {
-        report.keycode[0] = keycode; // 单键按下
+// 报告有变化时（并入宏回放按住的键后）放入HID类的报告队列
+// 队列满时保留变化标志，由主循环稍后重试
+// 队列只合并不会丢失按下/释放跳变的报告，因此每个按键事件都可以单独入队
+static void Submit_Keyboard_Report(void) {
+    KeyboardReport report;
+    uint8_t buf[HID_NKRO_REPORT_SIZE];
+    uint8_t itf;
+    uint16_t len;
+
+    if (!KeyboardReport_IsDirty(&keyboard_report)) {
+        return;
     }
 
-    // 通过USB发送报告
-    USBD_HID_SendReport(&hUsbDeviceFS, (uint8_t*)&report, sizeof(report));
-    HAL_Delay(20); // 等待数据发送完成
+    report = keyboard_report;
+    Macro_ApplyToReport(&report);
+    len = Encode_Report(&report, buf, &itf);
+
+    if (USBD_HID_SendReportItf(&hUsbDeviceFS, itf, buf, len) != USBD_OK) {
+        return;
+    }
+    KeyboardReport_ClearDirty(&keyboard_report);
+    // 挂起期间入队的报告在总线恢复后才发出；与恢复中断互斥地判断状态
+    __disable_irq();
+    if (hUsbDeviceFS.dev_state == USBD_STATE_SUSPENDED) usb_report_held = true;
+    __enable_irq();
+    hid_report_submit_us = Timebase_Micros();
+    hid_scan_to_usb_us = (uint32_t)(hid_report_submit_us - report_event_us);
+    if (hid_scan_to_usb_us > hid_scan_to_usb_max_us) hid_scan_to_usb_max_us = hid_scan_to_usb_us;
+}
+
+// 发送一次单键敲击（按下+释放），由宏引擎在后续两个轮询时隙中异步完成
+// keycode 为0时停止当前宏并释放其按住的键；已有宏在回放时忽略本次敲击
+void Send_HID_Report(uint8_t keycode) {
+    static MacroStep tap[2];
+
+    if (keycode == 0) {
+        Macro_Stop();
+        return;
+    }
+    if (Macro_IsPlaying()) {
+        return;
+    }
+    tap[0] = (MacroStep){ .op = MACRO_TAP, .key_code = keycode };
+    tap[1] = (MacroStep){ .op = MACRO_END };
+    Macro_Play(tap);
 }
 
 /* USER CODE END PV */
@@ -85,6 +174,65 @@ void SystemClock_Config(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+// USB挂起处理，主循环每轮调用：
+// 挂起时熄灭背光、停止矩阵扫描（改由列线EXTI唤醒）并进入STOP模式；
+// 挂起期间按键按下时，若主机允许，发送远程唤醒信号；总线恢复后恢复背光
+static void USB_Power_Process(void)
+{
+    if (hUsbDeviceFS.dev_state != USBD_STATE_SUSPENDED) {
+        if (usb_suspended) {
+            usb_suspended = false;
+            if (usb_wakeup_signal_us != 0U) {
+                HAL_PCD_DeActivateRemoteWakeup(&hpcd_USB_OTG_FS);
+                usb_wakeup_signal_us = 0;
+            }
+            WS2812_Resume();
+        }
+        return;
+    }
+
+    if (!usb_suspended) {
+        usb_suspended = true;
+        usb_wakeup_request = false;
+        usb_resume_pending = false; // 上次恢复后没有报告发出，不跨挂起计时
+        WS2812_Suspend();
+    }
+
+    // 远程唤醒信号保持 USB_REMOTE_WAKEUP_US 后撤销，随后由主机发出恢复信号
+    if (usb_wakeup_signal_us != 0U) {
+        if (Timebase_Micros() - usb_wakeup_signal_us >= USB_REMOTE_WAKEUP_US) {
+            HAL_PCD_DeActivateRemoteWakeup(&hpcd_USB_OTG_FS);
+            usb_wakeup_signal_us = 0;
+        }
+        return;
+    }
+    if (usb_wakeup_request) {
+        usb_wakeup_request = false;
+        if (hUsbDeviceFS.dev_remote_wakeup != 0U) {
+            __HAL_PCD_UNGATE_PHYCLOCK(&hpcd_USB_OTG_FS);
+            HAL_PCD_ActivateRemoteWakeup(&hpcd_USB_OTG_FS);
+            usb_wakeup_signal_us = Timebase_Micros() | 1U;
+            usb_wakeup_sent = true;
+        }
+        return;
+    }
+
+    // 有键按住时无法由边沿唤醒，保持扫描
+    if (!MatrixKeyboard_Sleep()) {
+        return;
+    }
+
+    // 关中断进入STOP：唤醒后先恢复PLL时钟，再响应唤醒中断（列线EXTI / USB唤醒EXTI18）
+    // 注意DWT计数在STOP期间停止，Timebase_Micros() 不计入STOP时间
+    __disable_irq();
+    if (hUsbDeviceFS.dev_state == USBD_STATE_SUSPENDED && MatrixKeyboard_IsIdle()) {
+        HAL_SuspendTick();
+        HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+        SystemClock_Config(); // STOP唤醒后系统时钟为HSI
+        HAL_ResumeTick();
+    }
+    __enable_irq();
+}
 
 /* USER CODE END 0 */
 
@@ -111,6 +259,7 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  Timebase_Init();
 
   /* USER CODE END SysInit */
 
@@ -121,20 +270,21 @@ int main(void)
   MX_TIM4_Init();
   /* USER CODE BEGIN 2 */
   WS2812_Init();
-  HAL_TIM_Base_Start_IT(&htim3);
-  MatrixKeyboard_Init();
+#if (MATRIX_SCAN_DMA)
+  MX_TIM1_Init();
+#endif
+  MatrixKeyboard_Init(); // 初始化完成后由模块自行启动扫描（TIM3 或 TIM1 + DMA）
   /* 定义一个缓冲区来接收按键事件 */
-   KeyEvent key_events_buffer[MAX_PRESSED_KEYS];
+   KeyEvent key_events_buffer[MATRIX_EVENT_QUEUE_SIZE];
    
-  // 用于标记HID报告是否需要更新并发送
-  bool report_needs_update = false;
+  uint8_t hid_protocol = HID_PROTOCOL_REPORT; // 主机当前选择的报告布局
 
   // 清空初始的键盘报告
-  memset(&keyboard_report, 0, sizeof(keyboard_report));
+  KeyboardReport_Init(&keyboard_report);
   
   // 模式切换相关变量
-  static uint32_t num_lock_press_time = 0;
   static bool num_lock_long_press_handled = false;
+  static uint8_t num_lock_press_leds = 0; // Num Lock 按下时主机的锁定键状态
   
   // 设置默认背光模式
   WS2812_SetMode(WS2812_MODE_STATIC);
@@ -146,145 +296,136 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-    // 1. 从事件队列获取按键事件（由TIM3中断产生）
-        uint8_t event_count = 0;
-        for (uint8_t i = 0; i < MAX_PRESSED_KEYS; i++) {
-            if (MatrixKeyboard_PopEvent(&key_events_buffer[i])) {
-                event_count++;
-            } else {
-                break;
+        USB_Power_Process();
+
+    // 主机切换启动/报告协议后HID类会清空报告队列：原接口补一次全释放报告，
+    // 再在新接口上按新布局重新提交当前状态
+        if (USBD_HID_GetProtocol(&hUsbDeviceFS) != hid_protocol) {
+            uint8_t released[HID_NKRO_REPORT_SIZE] = { HID_REPORT_ID_NKRO };
+
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+            if (hid_protocol != HID_PROTOCOL_BOOT) {
+                USBD_HID_SendReportItf(&hUsbDeviceFS, HID_ITF_EXTRA, released, HID_NKRO_REPORT_SIZE);
+            } else
+#endif
+            {
+                USBD_HID_SendReportItf(&hUsbDeviceFS, HID_ITF_KEYBOARD, &released[1], HID_BOOT_REPORT_SIZE);
             }
+            hid_protocol = USBD_HID_GetProtocol(&hUsbDeviceFS);
+            Report_Touch(Timebase_Micros());
         }
 
-        // 2. 如果有任何事件发生，则处理它们
-        if (event_count > 0) {
-            // 标记报告需要更新
-            report_needs_update = true;
+#if (MATRIX_DELTA_EVENTS)
+    // 0. 矩阵增量：每条对应一个扫描周期的全部按下/释放，逐位更新报告后整体入队
+        MatrixDelta delta;
+        while (MatrixKeyboard_PopDelta(&delta)) {
+            for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+                uint32_t changed = delta.changed[w];
+
+                while (changed != 0U) {
+                    uint32_t b = (uint32_t)__builtin_ctz(changed);
+                    uint32_t k = ((uint32_t)w << 5) + b;
+                    uint8_t row = (uint8_t)(k / COL_NUM);
+                    uint8_t col = (uint8_t)(k % COL_NUM);
+                    uint8_t key_code = MatrixKeyboard_GetKeyCode(row, col);
+                    changed &= changed - 1U;
+
+                    if (delta.state[w] & (1UL << b)) {
+                        if (k == 0) {
+                            num_lock_long_press_handled = false; // Num Lock 重新按下
+                            num_lock_press_leds = USBD_HID_GetLedState(&hUsbDeviceFS);
+                        }
+                        Report_Key(key_code, true, delta.timestamp_us);
+                        WS2812_OnKeyPress(row, col);
+                    } else {
+                        Report_Key(key_code, false, delta.timestamp_us);
+                        WS2812_OnKeyRelease(row, col);
+                    }
+                }
+            }
+            // 每条增量单独入队，同一扫描周期内每个按键至多一次跳变
+            Submit_Keyboard_Report();
+        }
+#endif
 
-            for (uint8_t i = 0; i < event_count; i++) {
-                KeyEvent event = key_events_buffer[i];
+    // 1. 一次取空事件队列（由扫描下半部产生；增量模式下只有长按/连发）
+        uint8_t event_count = MatrixKeyboard_PopEvents(key_events_buffer, MATRIX_EVENT_QUEUE_SIZE);
 
-                // 检查是否是Num Lock键 (ROW0, COL0, 键码0x53)
-                bool is_num_lock = (event.row == 0 && event.col == 0 && event.key_code == 0x53);
+        // 2. 逐个处理事件，每个事件只增量按下/释放报告中的一个键
+        for (uint8_t i = 0; i < event_count; i++) {
+            KeyEvent event = key_events_buffer[i];
 
-                if (event.event == KEY_EVENT_PRESS) 
-                {
-                    if (is_num_lock) {
-                        num_lock_press_time = HAL_GetTick();
-                        num_lock_long_press_handled = false;
-                    }
-                    
-                    // 按下事件: 将键码添加到HID报告中
-                    // 查找一个空位来存放新的键码
-                    for (int j = 0; j < 6; j++) {
-                        if (keyboard_report.keycode[j] == 0x00) {
-                            keyboard_report.keycode[j] = event.key_code;
-                            break;
-                        }
-                    }
-                    
-                    // 通知WS2812按键按下事件
-                    WS2812_OnKeyPress(event.row, event.col);
+            // 检查是否是Num Lock键 (ROW0, COL0, 键码0x53)
+            bool is_num_lock = (event.row == 0 && event.col == 0 && event.key_code == 0x53);
+
+            if (event.event == KEY_EVENT_PRESS) 
+            {
+                if (is_num_lock) {
+                    num_lock_long_press_handled = false;
+                    num_lock_press_leds = USBD_HID_GetLedState(&hUsbDeviceFS);
                 }
-                else if (event.event == KEY_EVENT_LONG_PRESS) 
-                {
-                    if (is_num_lock && !num_lock_long_press_handled) {
-                        // Num Lock长按切换背光模式
-                        WS2812_NextMode();
-                        num_lock_long_press_handled = true;
-                        
-                        // 不发送Num Lock的HID报告，避免切换系统Num Lock状态
-                        continue;
-                    }
-                    
-                    // 其他键的长按处理
-                    for (int j = 0; j < 6; j++) {
-                        if (keyboard_report.keycode[j] == 0x00) {
-                            keyboard_report.keycode[j] = event.key_code;
-                            break;
-                        }
-                    }
+                
+                // 按下事件: 在HID报告中按下该键
+                Report_Key(event.key_code, true, event.timestamp_us);
+                
+                // 通知WS2812按键按下事件
+                WS2812_OnKeyPress(event.row, event.col);
+            }
+            else if (event.event == KEY_EVENT_LONG_PRESS) 
+            {
+                if (is_num_lock && !num_lock_long_press_handled) {
+                    // Num Lock长按切换背光模式
+                    WS2812_NextMode();
+                    num_lock_long_press_handled = true;
                     
-                    WS2812_OnKeyPress(event.row, event.col);
-                }
-                else if (event.event == KEY_EVENT_REPEAT) 
-                {
-                    // 连发事件处理
-                    if (!is_num_lock) {  // Num Lock不处理连发
-                        for (int j = 0; j < 6; j++) {
-                            if (keyboard_report.keycode[j] == 0x00) {
-                                keyboard_report.keycode[j] = event.key_code;
-                                break;
-                            }
-                        }
+                    // 从报告中撤下Num Lock，松开时不再上报
+                    Report_Key(event.key_code, false, event.timestamp_us);
+
+                    // 按下时主机已切换了Num Lock：再敲一次恢复原来的锁定状态
+                    if ((USBD_HID_GetLedState(&hUsbDeviceFS) ^ num_lock_press_leds) & HID_LED_NUM_LOCK) {
+                        Send_HID_Report(event.key_code);
                     }
                 }
-                else if (event.event == KEY_EVENT_RELEASE) 
-                {
-                    if (is_num_lock) {
-                        uint32_t press_duration = HAL_GetTick() - num_lock_press_time;
-                        
-                        // 如果是短按且没有处理过长按，则正常发送Num Lock
-                        if (press_duration < 1000 && !num_lock_long_press_handled) {
-                            // 正常的Num Lock短按，发送HID报告
-                        } else {
-                            // 长按释放，不发送HID报告
-                            continue;
-                        }
-                    }
-                    
-                    // 释放事件: 从HID报告中移除该键码
-                    for (int j = 0; j < 6; j++) {
-                        if (keyboard_report.keycode[j] == event.key_code) {
-                            keyboard_report.keycode[j] = 0x00; // 清除
-                        }
-                    }
-                    
-                    // 通知WS2812按键释放事件
-                    WS2812_OnKeyRelease(event.row, event.col);
+                else if (!is_num_lock) {
+                    // 其他键的长按：保持按下状态（已按下时报告不变）
+                    Report_Key(event.key_code, true, event.timestamp_us);
+                    WS2812_OnKeyPress(event.row, event.col);
                 }
             }
-        }
-
-        // 3. 检查是否需要发送HID报告
-        // 只有在按键状态变化时才发送，这比每次循环都发送更高效
-        if (report_needs_update) {
-            // 清除更新标记
-            report_needs_update = false;
-
-            // 发送HID报告（仅在状态变化时发送）
-            USBD_HID_SendReport(&hUsbDeviceFS, (uint8_t*)&keyboard_report, sizeof(keyboard_report));
-            
-            // 为了处理按键释放，我们需要在发送完有效报告后，
-            // 立即发送一个全零的 "释放" 报告。
-            // 但更好的做法是让PC自己处理按键释放。
-            // 只有当所有按键都释放时，我们才需要发送一个全零报告。
-            // 我们可以通过检查 keyboard_report 是否全为0来判断。
-            bool all_keys_released = true;
-            for(int j=0; j<6; j++) {
-                if (keyboard_report.keycode[j] != 0) {
-                    all_keys_released = false;
-                    break;
-                }
+            else if (event.event == KEY_EVENT_REPEAT) 
+            {
+                // 连发由主机按按住状态自行产生，报告无需变化
+                continue;
             }
-
-            // 如果所有按键都释放了，并且上一次不是全零报告，则发送一次全零报告
-            if(all_keys_released){
-                 // 稍作延时，确保上一个报告被PC接收
-                 // HAL_Delay(1); 
-                 // 发送全零报告
-                 memset(&keyboard_report, 0, sizeof(keyboard_report));
-                 USBD_HID_SendReport(&hUsbDeviceFS, (uint8_t*)&keyboard_report, sizeof(keyboard_report));
+            else if (event.event == KEY_EVENT_RELEASE) 
+            {
+                // 释放事件: 在HID报告中释放该键
+                // （Num Lock 长按时已提前释放，此处报告不变，不会再次提交）
+                Report_Key(event.key_code, false, event.timestamp_us);
+                
+                // 通知WS2812按键释放事件
+                WS2812_OnKeyRelease(event.row, event.col);
             }
+
+            // 每个事件后的报告单独入队，避免同一批中的按下+释放相互抵消
+            // 报告未变化时（如增量模式下的长按）不提交
+            Submit_Keyboard_Report();
         }
 
-        // 处理WS2812动态效果
-        WS2812_ProcessEffects();
-        
-        // 更新 WS2812 LED 如果有变化
-        if (report_needs_update) {
-            WS2812_Update();
+        // 宏回放：每个轮询时隙至多推进一次跳变，未枚举时不推进
+        if (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED && Macro_Process(Timebase_Micros())) {
+            Report_Touch(Timebase_Micros());
+            Submit_Keyboard_Report();
         }
+
+        // 3. 提交尚未入队的报告：队列满时的重试，以及协议切换后的重新提交
+        Submit_Keyboard_Report();
+
+        // 诊断控制台命令（未启用 USBD_CDC_CONSOLE 时为空操作）
+        Console_Process();
+
+        // 灯效：到帧时刻（WS2812_FRAME_RATE_HZ）时推进动态效果，帧缓冲有变化才发送
+        WS2812_ProcessEffects();
         
         // 可以在这里加一个非常短的延时，以降低CPU使用率，但不是必须的
         // HAL_Delay(1); 
@@ -347,6 +488,60 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     MatrixKeyboard_ScanStep_ISR();
   }
 }
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  MatrixKeyboard_EXTI_ISR(GPIO_Pin);
+}
+
+void USBD_HID_LedStateChanged(USBD_HandleTypeDef *pdev, uint8_t leds)
+{
+  UNUSED(pdev);
+  WS2812_SetLockIndicators(leds); // 只记录状态，由主循环刷新LED
+}
+
+// USB恢复中断（HAL_PCD_ResumeCallback）中调用，此时设备状态尚未离开挂起
+// 时钟已在STOP唤醒后由主循环恢复，DWT计数有效
+void USB_Resume_Callback(void)
+{
+  if (usb_wakeup_sent || usb_report_held || KeyboardReport_IsDirty(&keyboard_report)) {
+    usb_resume_us = Timebase_Micros();
+    usb_resume_pending = true;
+  }
+  usb_wakeup_sent = false;
+  usb_report_held = false;
+}
+
+void USBD_HID_ReportSent(USBD_HandleTypeDef *pdev, uint8_t itf)
+{
+  UNUSED(pdev);
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  if (itf == HID_ITF_RAW) return;
+#else
+  UNUSED(itf);
+#endif
+
+  Macro_OnReportSent(); // 键盘报告被主机取走，宏可以推进下一步
+
+  if (usb_resume_pending) {
+    usb_resume_pending = false;
+    usb_resume_to_report_us = (uint32_t)(Timebase_Micros() - usb_resume_us);
+    if (usb_resume_to_report_us > usb_resume_to_report_max_us) usb_resume_to_report_max_us = usb_resume_to_report_us;
+  }
+}
+
+#if (USBD_CDC_CONSOLE == 1U)
+void Console_AppStats(void)
+{
+  Console_Printf("latency: scan->usb %lu us (max %lu), resume->report %lu us (max %lu)\r\n",
+                 (unsigned long)hid_scan_to_usb_us, (unsigned long)hid_scan_to_usb_max_us,
+                 (unsigned long)usb_resume_to_report_us, (unsigned long)usb_resume_to_report_max_us);
+  Console_Printf("leds: %lu frames presented, %lu dropped; effects %lu us total, max %lu us/frame, %lu over budget\r\n",
+                 (unsigned long)WS2812_GetPresentedFrames(), (unsigned long)WS2812_GetDroppedFrames(),
+                 (unsigned long)WS2812_GetEffectTimeUs(), (unsigned long)WS2812_GetEffectMaxUs(),
+                 (unsigned long)WS2812_GetOverBudgetFrames());
+}
+#endif
 /* USER CODE END 4 */
 
 /**
@@ -1,7 +1,14 @@
 #include "matrix_keyboard.h"
+#include "tim.h"
+#include "timebase.h"
 #include <string.h>
 #include <stdbool.h>
 
+#ifndef MATRIX_EXTERNAL_LAYOUT
+#if (ROW_NUM != 5) || (COL_NUM != 4)
+#error "the built-in pins and Key_Map are 5x4: provide ROW_Port/ROW_Pin/COL_Port/COL_Pin/Key_Map and define MATRIX_EXTERNAL_LAYOUT"
+#endif
+
 // --- GPIO 配置 (与您原来的代码一致) ---
 static GPIO_TypeDef* ROW_Port[ROW_NUM] = {GPIOE, GPIOE, GPIOE, GPIOE, GPIOE};
 static uint16_t ROW_Pin[ROW_NUM] = {GPIO_PIN_15, GPIO_PIN_14, GPIO_PIN_13, GPIO_PIN_12, GPIO_PIN_11};
@@ -17,63 +24,346 @@ static const uint8_t Key_Map[ROW_NUM][COL_NUM] = {
     /* ROW3 */ {0x5F, 0x60, 0x61, 0x00}, // 1,2,3 (原代码可能是7,8,9)
     /* ROW4 */ {0x62, 0x63, 0x58, 0x00}  // 0,.,enter
 };
-
-// --- 内部状态定义 ---
-typedef enum {
-    STATE_IDLE,       // 0. 空闲（已释放）
-    STATE_DEBOUNCE,   // 1. 消抖
-    STATE_PRESSED,    // 2. 已按下
-    STATE_LONG_PRESS  // 3. 长按
-} KeyState;
-
-// --- 静态变量 ---
-// 存储每个按键的独立状态
-static struct {
-    KeyState state;       // 当前状态
-    uint32_t timer;       // 计时器，用于消抖和长按判断
-} s_key_fsm[ROW_NUM][COL_NUM]; // FSM: Finite State Machine
-
-// 积分消抖计数器
-static uint8_t s_int_cnt[ROW_NUM][COL_NUM];
+#endif // MATRIX_EXTERNAL_LAYOUT
+
+// --- 消抖阈值 ---
+// 纵向计数器统计"原始电平与消抖状态不一致"的采样数：未按下的键要求连续，一致即清零；
+// 已按下的键与原积分器相同只减不增，接触采样保持计数，释放采样累计。
+// 原积分器首个按下采样只进入消抖状态，之后积分到 INT_PRESS_THRESH 才上报，即第 INT_PRESS_THRESH + 1 个采样；
+// 释放从 INT_PRESS_THRESH 降到 INT_RELEASE_THRESH，需 (INT_PRESS_THRESH - INT_RELEASE_THRESH) 个释放采样。
+// 两个计数按此取值，与原积分器在同一采样上报。
 #define INT_PRESS_THRESH    5   // 达到该积分认定为按下
 #define INT_RELEASE_THRESH  2   // 下降到该积分认定为释放
 
-// 上次处理的时间戳
-static uint32_t s_last_process_tick = 0;
+#define VC_PRESS_COUNT      (INT_PRESS_THRESH + 1)
+#define VC_RELEASE_COUNT    (INT_PRESS_THRESH - INT_RELEASE_THRESH)
+
+#if (VC_PRESS_COUNT < 1) || (VC_PRESS_COUNT > 7) || (VC_RELEASE_COUNT < 1) || (VC_RELEASE_COUNT > 7)
+#error "vertical counter is 3 bits wide: debounce counts must be within 1..7"
+#endif
+
+#if (MATRIX_DEBOUNCE_MODE != DEBOUNCE_EAGER_PK) && ((KEY_EAGER_LOCKOUT_MS < 1) || (KEY_EAGER_LOCKOUT_MS > 7))
+#error "DEBOUNCE_ASYM_EAGER keeps the lockout in the 3-bit vertical counter: use 1..7 ms or DEBOUNCE_EAGER_PK"
+#endif
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK) && ((KEY_EAGER_LOCKOUT_MS < 1) || (KEY_EAGER_LOCKOUT_MS > 255))
+#error "DEBOUNCE_EAGER_PK lockout must be within 1..255 ms"
+#endif
+
+// 3位纵向计数器等于常量 n 的按键掩码（n 为编译期常量，分支会被折叠掉）
+#define VC_MATCH(c0, c1, c2, n) \
+    ((((n) & 1U) ? (c0) : ~(c0)) & (((n) & 2U) ? (c1) : ~(c1)) & (((n) & 4U) ? (c2) : ~(c2)))
+
+// ---- 位并行扫描状态 ----
+// 行位图：bit c 对应第 c 列；矩阵位图：按键索引 k = r * COL_NUM + c，每个字32个按键
+typedef uint32_t MatrixRowBits;
+#if COL_NUM > 32
+#error "COL_NUM must not exceed 32 (one MatrixRowBits word per row)"
+#endif
+
+static MatrixRowBits s_valid_bits[ROW_NUM]; // Key_Map 非零的有效按键
+
+// 列端口分组：同一端口的多列只需读一次 IDR
+static GPIO_TypeDef* s_col_ports[COL_NUM];
+static uint8_t s_col_port_idx[COL_NUM];
+static uint8_t s_col_port_num = 0;
+
+// ---- 纵向计数器消抖状态（3个位平面 + 消抖结果） ----
+#if (MATRIX_DEBOUNCE_MODE != DEBOUNCE_EAGER_PK)
+static uint32_t s_vc0[MATRIX_WORDS];
+static uint32_t s_vc1[MATRIX_WORDS];
+static uint32_t s_vc2[MATRIX_WORDS];
+// 两种纵向计数器模式可在运行时切换：主循环写请求，下半部在采样间隙生效
+static volatile uint8_t s_debounce_req = MATRIX_DEBOUNCE_MODE;
+static uint8_t s_debounce_mode = MATRIX_DEBOUNCE_MODE;
+#endif
+static uint32_t s_debounced[MATRIX_WORDS]; // 消抖后的按下状态
+static uint32_t s_lock_bits[MATRIX_WORDS]; // 急按下模式：处于锁定窗口的按键（对称模式下恒为0）
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK)
+static uint32_t s_pk_cnt_bits[MATRIX_WORDS]; // 计数非零的按键
+#endif
+
+// ---- 逐键状态（只对翻转/按住/计数中的按键访问，紧凑存放在一个连续数组） ----
+// timer 低15位为计时起点（ms计数的低15位，差值按15位回绕计算），最高位为"已触发长按"
+#define KEY_TIMER_MASK 0x7FFFU
+#define KEY_TIMER_LONG 0x8000U
+#if (KEY_LONG_PRESS_TIME > KEY_TIMER_MASK) || (KEY_REPEAT_INTERVAL > KEY_TIMER_MASK)
+#error "long-press/repeat intervals must fit the 15-bit per-key timer"
+#endif
+
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK)
+#pragma pack(push, 1)
+#endif
+typedef struct {
+    uint16_t timer; // 按下/长按/连发计时起点 + 长按标志
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK)
+    uint8_t cnt;    // 逐键计数：锁定时为剩余锁定采样数，否则为连续释放采样数
+#endif
+} KeyState;         // 2字节（DEBOUNCE_EAGER_PK 为3字节）
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK)
+#pragma pack(pop)
+#endif
+
+static KeyState s_keys[MATRIX_KEY_NUM];
+
+// 15位回绕计时差
+static inline uint16_t key_elapsed(uint16_t start, uint16_t now)
+{
+    return (uint16_t)((now - start) & KEY_TIMER_MASK);
+}
+
+// ---- 空闲唤醒 ----
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+static uint16_t s_col_exti_mask = 0;  // 列线对应的EXTI线（线号即引脚号）
+static uint32_t s_idle_ms = 0;        // 连续无按键活动的时间 (ms)
+static uint32_t s_idle_tick_ms = 0;   // 上一个快照的采样时刻，用于累计空闲时间
+static volatile bool s_idle = false;  // 已停止扫描，等待列线唤醒
+#endif
+
+// ---- DMA扫描 ----
+#if (MATRIX_SCAN_DMA)
+#define SCAN_DMA_FRAMES  (MATRIX_SCAN_HZ / 1000)            // 每个半区（1ms）的整帧数
+#define SCAN_DMA_SAMPLES (2 * SCAN_DMA_FRAMES * ROW_NUM)    // 双半区采样总数
+#if (MATRIX_SCAN_HZ % 1000) != 0 || (SCAN_DMA_FRAMES < 1)
+#error "MATRIX_SCAN_HZ must be a non-zero multiple of 1000"
+#endif
+
+extern DMA_HandleTypeDef hdma_tim1_up;
+extern DMA_HandleTypeDef hdma_tim1_ch1;
+
+static uint32_t s_row_bsrr[ROW_NUM];             // 第 j 步写入BSRR的图样：选中第 (j+1) % ROW_NUM 行，其余行拉低
+static uint16_t s_col_samples[SCAN_DMA_SAMPLES]; // 列端口IDR采样，第 i 个对应第 i % ROW_NUM 行
+#endif
+
+// ---- 事件队列（单生产者：PendSV下半部；单消费者：主循环） ----
+// 生产者只写 head、消费者只写 tail，两侧都不关中断。队列满时不丢弃按下/释放：
+// 记入待上报位图，有空位后按"消抖状态与已上报状态之差"补发，同一键积压期间的按下+释放相互抵消；
+// LONG_PRESS/REPEAT 不影响按键状态，队列满时直接丢弃。
+#if (MATRIX_EVENT_QUEUE_SIZE & (MATRIX_EVENT_QUEUE_SIZE - 1)) != 0 || (MATRIX_EVENT_QUEUE_SIZE > 128)
+#error "MATRIX_EVENT_QUEUE_SIZE must be a power of two not larger than 128"
+#endif
+#define EVT_MASK (MATRIX_EVENT_QUEUE_SIZE - 1U)
 
-// ---- 事件队列（ISR生产，主循环消费） ----
-#define EVENT_QUEUE_SIZE 32
 static volatile uint8_t s_evt_head = 0;
 static volatile uint8_t s_evt_tail = 0;
-static KeyEvent s_evt_queue[EVENT_QUEUE_SIZE];
+static KeyEvent s_evt_queue[MATRIX_EVENT_QUEUE_SIZE];
+#if (!MATRIX_DELTA_EVENTS)
+static uint32_t s_evt_reported[MATRIX_WORDS]; // 已入队事件所表示的按下状态
+static uint32_t s_evt_pending[MATRIX_WORDS];  // 因队列满尚未入队的状态变化
+#endif
+static volatile uint32_t s_evt_overflows = 0; // 队列满时被合并或丢弃的事件数
+static uint64_t s_bh_time_us = 0;              // 下半部正在处理的快照的采样时刻，作为事件时间戳
+
+#if (MATRIX_DELTA_EVENTS)
+// ---- 矩阵增量队列（每个扫描周期最多一条，生产/消费方式同事件队列） ----
+// 队列满时不入队，下个周期以"消抖状态与已入队状态之差"合并补发
+#if (MATRIX_DELTA_QUEUE_SIZE & (MATRIX_DELTA_QUEUE_SIZE - 1)) != 0 || (MATRIX_DELTA_QUEUE_SIZE > 128)
+#error "MATRIX_DELTA_QUEUE_SIZE must be a power of two not larger than 128"
+#endif
+#define DELTA_MASK (MATRIX_DELTA_QUEUE_SIZE - 1U)
+
+static volatile uint8_t s_delta_head = 0;
+static volatile uint8_t s_delta_tail = 0;
+static MatrixDelta s_delta_queue[MATRIX_DELTA_QUEUE_SIZE];
+static uint32_t s_delta_reported[MATRIX_WORDS]; // 已入队增量所表示的按下状态
+#endif
+
+static inline bool push_event_isr(uint8_t r, uint8_t c, KeyEventType type)
+{
+    uint8_t head = s_evt_head;
+    uint8_t next_head = (uint8_t)((head + 1U) & EVT_MASK);
+    if (next_head == s_evt_tail) return false; // 满
+
+    s_evt_queue[head].timestamp_us = s_bh_time_us;
+    s_evt_queue[head].key_code = Key_Map[r][c];
+    s_evt_queue[head].row = r;
+    s_evt_queue[head].col = c;
+    s_evt_queue[head].event = type;
+    __DMB(); // 事件内容先于写指针可见
+    s_evt_head = next_head;
+    return true;
+}
+
+// 状态变化尚未入队（积压中）的按键
+static inline uint32_t unreported_bits(uint8_t w)
+{
+#if (MATRIX_DELTA_EVENTS)
+    return s_debounced[w] ^ s_delta_reported[w];
+#else
+    return s_evt_pending[w];
+#endif
+}
+
+#if (!MATRIX_DELTA_EVENTS)
+static inline bool evt_pending_any(void)
+{
+    uint32_t any = 0;
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) any |= s_evt_pending[w];
+    return any != 0U;
+}
 
-static inline void push_event_isr(uint8_t r, uint8_t c, KeyEventType type)
+// 按下/释放事件：已有积压时也记入待上报位图，避免后发生的事件越过积压的事件先入队
+static void push_state_event_isr(uint32_t k, bool pressed)
 {
-    uint8_t next_head = (uint8_t)((s_evt_head + 1) % EVENT_QUEUE_SIZE);
-    if (next_head == s_evt_tail) {
-        // 队列满，丢弃最旧一个，释放一格
-        s_evt_tail = (uint8_t)((s_evt_tail + 1) % EVENT_QUEUE_SIZE);
+    uint32_t w = k >> 5;
+    uint32_t bit = 1UL << (k & 31U);
+
+    if (!evt_pending_any() &&
+        push_event_isr((uint8_t)(k / COL_NUM), (uint8_t)(k % COL_NUM), pressed ? KEY_EVENT_PRESS : KEY_EVENT_RELEASE)) {
+        s_evt_reported[w] ^= bit;
+        return;
     }
-    s_evt_queue[s_evt_head].key_code = Key_Map[r][c];
-    s_evt_queue[s_evt_head].row = r;
-    s_evt_queue[s_evt_head].col = c;
-    s_evt_queue[s_evt_head].event = type;
-    s_evt_head = next_head;
+    s_evt_pending[w] |= bit;
+    s_evt_overflows++;
 }
 
-bool MatrixKeyboard_PopEvent(KeyEvent* out_event)
+// 队列有空位后补发积压的状态变化（按键索引顺序）
+static void flush_pending_events_isr(void)
+{
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+        uint32_t work = s_evt_pending[w];
+
+        while (work != 0U) {
+            uint32_t b = (uint32_t)__builtin_ctz(work);
+            uint32_t bit = 1UL << b;
+            uint32_t k = ((uint32_t)w << 5) + b;
+            work &= work - 1U;
+
+            bool pressed = (s_debounced[w] & bit) != 0U;
+            if (pressed != ((s_evt_reported[w] & bit) != 0U)) {
+                if (!push_event_isr((uint8_t)(k / COL_NUM), (uint8_t)(k % COL_NUM),
+                                    pressed ? KEY_EVENT_PRESS : KEY_EVENT_RELEASE)) {
+                    return; // 仍然满，下个快照再试
+                }
+                s_evt_reported[w] ^= bit;
+            }
+            s_evt_pending[w] &= ~bit;
+        }
+    }
+}
+#else
+// 本周期有状态变化（或之前积压）时入队一条增量
+static void push_delta_isr(void)
+{
+    uint32_t diff = 0;
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) diff |= s_debounced[w] ^ s_delta_reported[w];
+    if (diff == 0U) return;
+
+    uint8_t head = s_delta_head;
+    uint8_t next_head = (uint8_t)((head + 1U) & DELTA_MASK);
+    if (next_head == s_delta_tail) {
+        s_evt_overflows++;
+        return;
+    }
+
+    MatrixDelta* d = &s_delta_queue[head];
+    d->timestamp_us = s_bh_time_us;
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+        d->changed[w] = s_debounced[w] ^ s_delta_reported[w];
+        d->state[w] = s_debounced[w];
+        s_delta_reported[w] = s_debounced[w];
+    }
+    __DMB(); // 增量内容先于写指针可见
+    s_delta_head = next_head;
+}
+
+bool MatrixKeyboard_PopDelta(MatrixDelta* out_delta)
 {
-    if (s_evt_tail == s_evt_head) return false; // 空
-    *out_event = s_evt_queue[s_evt_tail];
-    s_evt_tail = (uint8_t)((s_evt_tail + 1) % EVENT_QUEUE_SIZE);
+    uint8_t tail = s_delta_tail;
+
+    if (tail == s_delta_head) return false;
+    __DMB(); // 先读到写指针，再读增量内容
+    *out_delta = s_delta_queue[tail];
+    __DMB(); // 增量读完后才归还槽位
+    s_delta_tail = (uint8_t)((tail + 1U) & DELTA_MASK);
     return true;
 }
+#endif
+
+// 长按/连发事件：该键的按下尚未上报或队列满时丢弃
+static void push_timed_event_isr(uint32_t k, KeyEventType type)
+{
+    if ((unreported_bits((uint8_t)(k >> 5)) & (1UL << (k & 31U))) != 0U ||
+        !push_event_isr((uint8_t)(k / COL_NUM), (uint8_t)(k % COL_NUM), type)) {
+        s_evt_overflows++;
+    }
+}
+
+uint8_t MatrixKeyboard_PopEvents(KeyEvent* out_events, uint8_t max_events)
+{
+    uint8_t tail = s_evt_tail;
+    uint8_t head = s_evt_head;
+    uint8_t n = 0;
+
+    __DMB(); // 先读到写指针，再读事件内容
+    while (tail != head && n < max_events) {
+        out_events[n++] = s_evt_queue[tail];
+        tail = (uint8_t)((tail + 1U) & EVT_MASK);
+    }
+    __DMB(); // 事件读完后才归还槽位
+    s_evt_tail = tail;
+    return n;
+}
+
+bool MatrixKeyboard_PopEvent(KeyEvent* out_event)
+{
+    return MatrixKeyboard_PopEvents(out_event, 1) != 0U;
+}
 
-// 定时器ISR时间基准（ms）
+uint32_t MatrixKeyboard_GetEventOverflows(void)
+{
+    return s_evt_overflows;
+}
+
+uint8_t MatrixKeyboard_GetKeyCode(uint8_t row, uint8_t col)
+{
+    if (row >= ROW_NUM || col >= COL_NUM) return 0x00;
+    return Key_Map[row][col];
+}
+
+// 定时器ISR时间基准（ms）：每次扫描累加一个扫描周期，不足1ms的部分留在 s_isr_tick_frac_us
 static volatile uint32_t s_isr_tick_ms = 0;
+static uint32_t s_isr_tick_frac_us = 0;
+static volatile uint32_t s_scan_period_us = 1000; // 扫描周期；DMA方式下每个快照固定为1ms
+
+// ---- 扫描快照环（上半部：扫描ISR写入；下半部：PendSV读出并消抖） ----
+#define RAW_RING_SIZE 8 // 2的幂
+typedef struct {
+    uint64_t time_us;           // 采样完成时刻 (Timebase_Micros)
+    uint32_t tick_ms;           // 采样序号 (ms)，用于长按/连发计时
+    uint32_t any[MATRIX_WORDS]; // 1ms内任一帧按下（CPU扫描只有一帧，即原始位图）
+    uint32_t all[MATRIX_WORDS]; // 1ms内所有帧都按下
+} RawSnapshot;
+
+static RawSnapshot s_raw_ring[RAW_RING_SIZE];
+static volatile uint8_t s_raw_head = 0;
+static volatile uint8_t s_raw_tail = 0;
+static volatile uint32_t s_raw_overruns = 0; // 下半部积压导致丢弃的快照数
 
 // --- 函数实现 ---
 
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+// 列引脚对应的EXTI中断号
+static IRQn_Type col_exti_irqn(uint16_t pin)
+{
+    switch (pin) {
+        case GPIO_PIN_0: return EXTI0_IRQn;
+        case GPIO_PIN_1: return EXTI1_IRQn;
+        case GPIO_PIN_2: return EXTI2_IRQn;
+        case GPIO_PIN_3: return EXTI3_IRQn;
+        case GPIO_PIN_4: return EXTI4_IRQn;
+        case GPIO_PIN_5:
+        case GPIO_PIN_6:
+        case GPIO_PIN_7:
+        case GPIO_PIN_8:
+        case GPIO_PIN_9: return EXTI9_5_IRQn;
+        default:         return EXTI15_10_IRQn;
+    }
+}
+#endif
+
+static void scan_timer_start(void);
+static void scan_timer_stop(void);
+
 /**
  * @brief 初始化函数 (与您的版本基本相同，只是更整洁)
  */
@@ -94,227 +384,626 @@ void MatrixKeyboard_Init(void) {
         HAL_GPIO_Init(ROW_Port[i], &GPIO_InitStruct);
     }
 
-    // 3. 初始化列线 (下拉输入)
+    // 3. 初始化列线 (下拉输入；启用空闲唤醒时同时配置上升沿EXTI，平时屏蔽)
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+#else
     GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+#endif
     GPIO_InitStruct.Pull = GPIO_PULLDOWN;
     for (uint8_t i = 0; i < COL_NUM; i++) {
         GPIO_InitStruct.Pin = COL_Pin[i];
         HAL_GPIO_Init(COL_Port[i], &GPIO_InitStruct);
     }
-    
-    // 4. 初始化所有按键状态机
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+    s_col_exti_mask = 0;
+    for (uint8_t i = 0; i < COL_NUM; i++) s_col_exti_mask |= COL_Pin[i];
+    EXTI->IMR &= ~(uint32_t)s_col_exti_mask;
+    EXTI->PR = s_col_exti_mask;
+    for (uint8_t i = 0; i < COL_NUM; i++) {
+        IRQn_Type irqn = col_exti_irqn(COL_Pin[i]);
+        HAL_NVIC_SetPriority(irqn, IRQ_PRIO_MATRIX_SCAN, 0); // 与扫描上半部同优先级
+        HAL_NVIC_EnableIRQ(irqn);
+    }
+    s_idle_ms = 0;
+    s_idle_tick_ms = s_isr_tick_ms;
+    s_idle = false;
+#endif
+
+    // 4. 清空消抖与计时状态
+#if (MATRIX_DEBOUNCE_MODE != DEBOUNCE_EAGER_PK)
+    memset(s_vc0, 0, sizeof(s_vc0));
+    memset(s_vc1, 0, sizeof(s_vc1));
+    memset(s_vc2, 0, sizeof(s_vc2));
+#endif
+    memset(s_debounced, 0, sizeof(s_debounced));
+    memset(s_lock_bits, 0, sizeof(s_lock_bits));
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK)
+    memset(s_pk_cnt_bits, 0, sizeof(s_pk_cnt_bits));
+#endif
+    memset(s_keys, 0, sizeof(s_keys));
+#if (MATRIX_DELTA_EVENTS)
+    memset(s_delta_reported, 0, sizeof(s_delta_reported));
+    s_delta_head = 0;
+    s_delta_tail = 0;
+#else
+    memset(s_evt_reported, 0, sizeof(s_evt_reported));
+    memset(s_evt_pending, 0, sizeof(s_evt_pending));
+#endif
+    s_evt_head = 0;
+    s_evt_tail = 0;
+    s_evt_overflows = 0;
+
+    // 5. 预计算有效键位图
     for (uint8_t r = 0; r < ROW_NUM; r++) {
+        s_valid_bits[r] = 0;
         for (uint8_t c = 0; c < COL_NUM; c++) {
-            s_key_fsm[r][c].state = STATE_IDLE;
-            s_key_fsm[r][c].timer = 0;
-            s_int_cnt[r][c] = 0;
+            if (Key_Map[r][c] != 0x00) s_valid_bits[r] |= (1UL << c);
         }
     }
+
+    // 6. 按端口对列分组
+    s_col_port_num = 0;
+    for (uint8_t c = 0; c < COL_NUM; c++) {
+        uint8_t p = 0;
+        while (p < s_col_port_num && s_col_ports[p] != COL_Port[c]) p++;
+        if (p == s_col_port_num) s_col_ports[s_col_port_num++] = COL_Port[c];
+        s_col_port_idx[c] = p;
+    }
+
+#if (MATRIX_SCAN_DMA)
+    // 7. DMA只能访问一个行端口和一个列端口
+    uint32_t all_rows = 0;
+    for (uint8_t r = 0; r < ROW_NUM; r++) {
+        if (ROW_Port[r] != ROW_Port[0]) Error_Handler();
+        all_rows |= ROW_Pin[r];
+    }
+    if (s_col_port_num != 1) Error_Handler();
+
+    // BSRR中置位优先于复位：同时写"全部行复位 + 目标行置位"即完成换行
+    for (uint8_t j = 0; j < ROW_NUM; j++) {
+        s_row_bsrr[j] = (all_rows << 16) | ROW_Pin[(j + 1) % ROW_NUM];
+    }
+#endif
+
+    // 8. 下半部在最低优先级的PendSV中运行
+    s_raw_head = 0;
+    s_raw_tail = 0;
+    s_raw_overruns = 0;
+    HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIO_MATRIX_BH, 0);
+
+    // 9. 启动扫描
+    scan_timer_start();
+}
+
+// 读取当前行的所有列：每个列端口的IDR只读一次，再打包成列位图（bit c 对应第 c 列）
+static inline MatrixRowBits read_cols_isr(void)
+{
+    uint32_t idr[COL_NUM];
+    MatrixRowBits bits = 0;
+
+    for (uint8_t p = 0; p < s_col_port_num; p++) {
+        idr[p] = s_col_ports[p]->IDR;
+    }
+    for (uint8_t c = 0; c < COL_NUM; c++) {
+        bits |= (MatrixRowBits)((idr[s_col_port_idx[c]] & COL_Pin[c]) != 0U) << c;
+    }
+    return bits;
 }
 
+// 把一行的列位图放到矩阵位图的 r * COL_NUM 位置（可能跨越两个字）
+static inline void put_row_bits(uint32_t* words, uint8_t r, MatrixRowBits bits)
+{
+    uint32_t bit = (uint32_t)r * COL_NUM;
+    uint32_t w = bit >> 5;
+    uint32_t sh = bit & 31U;
 
-/**
- * @brief 核心处理函数 (非阻塞)
- */
-uint8_t MatrixKeyboard_Process(KeyEvent* p_key_events, uint8_t buffer_size) {
-    uint8_t event_count = 0;
-    uint32_t now = HAL_GetTick();
+    words[w] |= bits << sh;
+    if (sh != 0U && sh + COL_NUM > 32U) {
+        words[w + 1] |= bits >> (32U - sh);
+    }
+}
+
+#if (MATRIX_DEBOUNCE_MODE != DEBOUNCE_EAGER_PK)
+// 纵向计数器消抖：每次处理32个按键，返回本次翻转（按下或释放）的按键掩码
+static inline uint32_t debounce_word_sym(uint8_t w, uint32_t raw)
+{
+    uint32_t db = s_debounced[w];
+    uint32_t delta = raw ^ db; // 与消抖状态不一致的按键
+
+    // 不一致则计数+1；一致时未按下的键清零，已按下的键保持（计数在达到释放阈值的那次采样即翻转清零，不会越过阈值）
+    uint32_t keep = delta | db;
+    uint32_t c0 = s_vc0[w], c1 = s_vc1[w], c2 = s_vc2[w];
+    c2 = (c2 ^ (c1 & c0 & delta)) & keep;
+    c1 = (c1 ^ (c0 & delta)) & keep;
+    c0 = (c0 ^ delta) & keep;
+
+    // 已按下的键按释放阈值判定，未按下的键按按下阈值判定
+    uint32_t toggle = delta & ((db & VC_MATCH(c0, c1, c2, VC_RELEASE_COUNT)) |
+                               (~db & VC_MATCH(c0, c1, c2, VC_PRESS_COUNT)));
+
+    s_debounced[w] = db ^ toggle;
+    s_vc0[w] = c0 & ~toggle;
+    s_vc1[w] = c1 & ~toggle;
+    s_vc2[w] = c2 & ~toggle;
+    return toggle;
+}
 
-    // 使用时间片轮询，避免阻塞
-    if (now - s_last_process_tick < KEY_SCAN_INTERVAL) {
-        return 0;
+// 急按下消抖：未锁定的键首个按下采样立即翻转；翻转后锁定 KEY_EAGER_LOCKOUT_MS 次采样忽略抖动，
+// 解锁后释放仍需连续 VC_RELEASE_COUNT 次释放采样。锁定计时与释放计数共用同一组纵向计数器。
+static inline uint32_t debounce_word_eager(uint8_t w, uint32_t raw)
+{
+    uint32_t db = s_debounced[w];
+    uint32_t lock = s_lock_bits[w];
+
+    // 锁定中的键无条件计数；未锁定且按下的键在原始电平为释放时计数，否则清零
+    uint32_t inc = lock | (db & ~raw);
+    uint32_t c0 = s_vc0[w], c1 = s_vc1[w], c2 = s_vc2[w];
+    c2 = (c2 ^ (c1 & c0)) & inc;
+    c1 = (c1 ^ c0) & inc;
+    c0 = ~c0 & inc;
+
+    uint32_t unlock = lock & VC_MATCH(c0, c1, c2, KEY_EAGER_LOCKOUT_MS);
+    uint32_t press = ~lock & ~db & raw;
+    uint32_t release = ~lock & db & ~raw & VC_MATCH(c0, c1, c2, VC_RELEASE_COUNT);
+    uint32_t toggle = press | release;
+    uint32_t clear = unlock | toggle;
+
+    s_debounced[w] = db ^ toggle;
+    s_lock_bits[w] = (lock & ~unlock) | toggle;
+    s_vc0[w] = c0 & ~clear;
+    s_vc1[w] = c1 & ~clear;
+    s_vc2[w] = c2 & ~clear;
+    return toggle;
+}
+
+static inline bool debounce_deferred(void)
+{
+    return s_debounce_mode == DEBOUNCE_SYM_DEFER;
+}
+
+static inline uint32_t debounce_word(uint8_t w, uint32_t raw)
+{
+    return debounce_deferred() ? debounce_word_sym(w, raw) : debounce_word_eager(w, raw);
+}
+
+// 应用主循环请求的模式：两种模式的计数含义不同，清零进行中的计数与锁定，保留消抖结果
+static void debounce_apply_mode(void)
+{
+    if (s_debounce_req == s_debounce_mode) return;
+
+    s_debounce_mode = s_debounce_req;
+    memset(s_vc0, 0, sizeof(s_vc0));
+    memset(s_vc1, 0, sizeof(s_vc1));
+    memset(s_vc2, 0, sizeof(s_vc2));
+    memset(s_lock_bits, 0, sizeof(s_lock_bits));
+}
+#else
+// 逐键急按下消抖：行为同 DEBOUNCE_ASYM_EAGER，但每键用一个8位计数（锁定倒计时或连续释放计数），
+// 只遍历原始电平与消抖状态不一致、处于锁定或计数未清零的按键
+static inline uint32_t debounce_word(uint8_t w, uint32_t raw)
+{
+    uint32_t db = s_debounced[w];
+    uint32_t lock = s_lock_bits[w];
+    uint32_t cnt_bits = s_pk_cnt_bits[w];
+    uint32_t work = (raw ^ db) | lock | cnt_bits;
+    uint32_t toggle = 0;
+
+    while (work != 0U) {
+        uint32_t b = (uint32_t)__builtin_ctz(work);
+        uint32_t bit = 1UL << b;
+        uint8_t* cnt = &s_keys[((uint32_t)w << 5) + b].cnt;
+        work &= work - 1U;
+
+        if (lock & bit) {
+            // 锁定期间忽略原始电平
+            if (--(*cnt) == 0U) lock &= ~bit;
+        } else if (((raw ^ db) & bit) == 0U) {
+            *cnt = 0; // 电平与状态一致，释放计数清零
+            cnt_bits &= ~bit;
+        } else if ((db & bit) == 0U) {
+            toggle |= bit; // 急按下
+            *cnt = KEY_EAGER_LOCKOUT_MS;
+            lock |= bit;
+            cnt_bits &= ~bit;
+        } else if (++(*cnt) >= VC_RELEASE_COUNT) {
+            toggle |= bit; // 延迟释放
+            *cnt = KEY_EAGER_LOCKOUT_MS;
+            lock |= bit;
+            cnt_bits &= ~bit;
+        } else {
+            cnt_bits |= bit;
+        }
     }
-    s_last_process_tick = now;
 
-    // --- 硬件扫描 ---
+    s_debounced[w] = db ^ toggle;
+    s_lock_bits[w] = lock;
+    s_pk_cnt_bits[w] = cnt_bits;
+    return toggle;
+}
+
+static inline bool debounce_deferred(void)
+{
+    return false;
+}
+
+static inline void debounce_apply_mode(void)
+{
+}
+#endif
+
+// 对单个按键生成事件：只对翻转或仍按下且本次采样接触（需要长按/连发计时）的按键调用
+static inline void key_timer_step_isr(uint32_t k, bool toggled, bool pressed, uint32_t now)
+{
+    KeyState* ks = &s_keys[k];
+    uint16_t t = (uint16_t)(now & KEY_TIMER_MASK);
+
+    if (toggled) {
+        ks->timer = t; // 按下启动长按计时；释放清除长按标志
+#if (!MATRIX_DELTA_EVENTS)
+        push_state_event_isr(k, pressed);
+#else
+        (void)pressed;
+#endif
+    } else if ((ks->timer & KEY_TIMER_LONG) == 0U) {
+        if (key_elapsed(ks->timer, t) >= KEY_LONG_PRESS_TIME) {
+            ks->timer = t | KEY_TIMER_LONG; // 启动连发计时
+            push_timed_event_isr(k, KEY_EVENT_LONG_PRESS);
+        }
+    } else {
+        if (key_elapsed(ks->timer & KEY_TIMER_MASK, t) >= KEY_REPEAT_INTERVAL) {
+            ks->timer = t | KEY_TIMER_LONG; // 重置连发计时
+            push_timed_event_isr(k, KEY_EVENT_REPEAT);
+        }
+    }
+}
+
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+// 进入空闲（下半部调用）：拉高全部行，任意按键按下都会把所在列拉高，产生上升沿唤醒
+static void enter_idle_isr(void)
+{
+    scan_timer_stop();
+
     for (uint8_t r = 0; r < ROW_NUM; r++) {
-        // 1. 拉高当前行
-        HAL_GPIO_WritePin(ROW_Port[r], ROW_Pin[r], GPIO_PIN_SET);
+        ROW_Port[r]->BSRR = ROW_Pin[r];
+    }
 
-        // 2. 检查所有列 (这里不需要延时，GPIO电平变化很快)
-        for (uint8_t c = 0; c < COL_NUM; c++) {
-            // 如果按键的键码为0, 则跳过处理
-            if (Key_Map[r][c] == 0x00) continue;
-
-            // 读取物理按键状态 (按下为1, 弹起为0)
-            uint8_t is_pressed = (HAL_GPIO_ReadPin(COL_Port[c], COL_Pin[c]) == GPIO_PIN_SET);
-
-            // --- 独立状态机逻辑处理 ---
-            switch (s_key_fsm[r][c].state) {
-                case STATE_IDLE:
-                    if (is_pressed) {
-                        s_key_fsm[r][c].state = STATE_DEBOUNCE;
-                        s_int_cnt[r][c] = 0; // 积分从0开始
-                        s_key_fsm[r][c].timer = now; // 记录时间用于后续长按
-                    }
-                    break;
-
-                case STATE_DEBOUNCE:
-                    if (is_pressed) {
-                        if (s_int_cnt[r][c] < 255) s_int_cnt[r][c]++;
-                        if (s_int_cnt[r][c] >= INT_PRESS_THRESH) {
-                            s_key_fsm[r][c].state = STATE_PRESSED;
-                            s_key_fsm[r][c].timer = now; // 启动长按计时
-                            if (event_count < buffer_size) {
-                                p_key_events[event_count].key_code = Key_Map[r][c];
-                                p_key_events[event_count].row = r;
-                                p_key_events[event_count].col = c;
-                                p_key_events[event_count].event = KEY_EVENT_PRESS;
-                                event_count++;
-                            }
-                        }
-                    } else {
-                        if (s_int_cnt[r][c] > 0) s_int_cnt[r][c]--;
-                        if (s_int_cnt[r][c] == 0) {
-                            s_key_fsm[r][c].state = STATE_IDLE;
-                        }
-                    }
-                    break;
-
-                case STATE_PRESSED:
-                    if (is_pressed) {
-                        // 检查是否达到长按时间
-                        if (now - s_key_fsm[r][c].timer >= KEY_LONG_PRESS_TIME) {
-                            s_key_fsm[r][c].state = STATE_LONG_PRESS;
-                            s_key_fsm[r][c].timer = now; // 启动连发计时
-                            
-                            // 产生一个 "长按" 事件
-                            if (event_count < buffer_size) {
-                                p_key_events[event_count].key_code = Key_Map[r][c];
-                                p_key_events[event_count].row = r;
-                                p_key_events[event_count].col = c;
-                                p_key_events[event_count].event = KEY_EVENT_LONG_PRESS;
-                                event_count++;
-                            }
-                        }
-                    } else {
-                        // 积分下降判定释放
-                        if (s_int_cnt[r][c] > 0) s_int_cnt[r][c]--;
-                        if (s_int_cnt[r][c] <= INT_RELEASE_THRESH) {
-                            s_key_fsm[r][c].state = STATE_IDLE;
-                            if (event_count < buffer_size) {
-                                p_key_events[event_count].key_code = Key_Map[r][c];
-                                p_key_events[event_count].row = r;
-                                p_key_events[event_count].col = c;
-                                p_key_events[event_count].event = KEY_EVENT_RELEASE;
-                                event_count++;
-                            }
-                        }
-                    }
-                    break;
-                
-                case STATE_LONG_PRESS:
-                    if (is_pressed) {
-                        // 检查是否达到连发间隔
-                        if (now - s_key_fsm[r][c].timer >= KEY_REPEAT_INTERVAL) {
-                            s_key_fsm[r][c].timer = now; // 重置连发计时
-                            
-                            // 产生一个 "连发" 事件
-                            if (event_count < buffer_size) {
-                                p_key_events[event_count].key_code = Key_Map[r][c];
-                                p_key_events[event_count].row = r;
-                                p_key_events[event_count].col = c;
-                                p_key_events[event_count].event = KEY_EVENT_REPEAT;
-                                event_count++;
-                            }
-                        }
-                    } else {
-                        if (s_int_cnt[r][c] > 0) s_int_cnt[r][c]--;
-                        if (s_int_cnt[r][c] <= INT_RELEASE_THRESH) {
-                            s_key_fsm[r][c].state = STATE_IDLE;
-                            if (event_count < buffer_size) {
-                                p_key_events[event_count].key_code = Key_Map[r][c];
-                                p_key_events[event_count].row = r;
-                                p_key_events[event_count].col = c;
-                                p_key_events[event_count].event = KEY_EVENT_RELEASE;
-                                event_count++;
-                            }
-                        }
-                    }
-                    break;
-                
-            }
-        } // end of col loop
+    // 下半部优先级低于EXTI：打开EXTI到置位 s_idle 之间不能被唤醒回调抢占，否则唤醒会被忽略
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    EXTI->PR = s_col_exti_mask;
+    EXTI->IMR |= s_col_exti_mask;
+
+    // 拉高行到打开EXTI之间按下的键不会再产生边沿，补查一次电平
+    if (read_cols_isr() != 0U) {
+        EXTI->IMR &= ~(uint32_t)s_col_exti_mask;
+        __set_PRIMASK(primask);
+        for (uint8_t r = 0; r < ROW_NUM; r++) {
+            ROW_Port[r]->BSRR = ((uint32_t)ROW_Pin[r] << 16);
+        }
+        s_idle_ms = 0;
+        scan_timer_start();
+        return;
+    }
+
+    s_idle = true;
+    s_idle_ms = 0;
+    __set_PRIMASK(primask);
+}
+#endif
+
+// 下半部：处理一个1ms快照，整字消抖后只对翻转/按住的按键做逐键处理
+static void process_snapshot(const RawSnapshot* snap)
+{
+    uint32_t raw[MATRIX_WORDS];
+    uint32_t now = snap->tick_ms;
+
+    s_bh_time_us = snap->time_us;
+    debounce_apply_mode();
+
+#if (!MATRIX_DELTA_EVENTS)
+    flush_pending_events_isr();
+#endif
+
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+        if (debounce_deferred()) {
+            // 1ms内所有帧都变化才计为一次变化采样，帧间抖动视为未变化
+            raw[w] = (s_debounced[w] & snap->any[w]) | snap->all[w];
+        } else {
+            // 急按下：任一帧接触即视为按下；释放需所有帧都断开
+            raw[w] = snap->any[w];
+        }
+    }
+
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+        uint32_t toggle = debounce_word(w, raw[w]);
+        uint32_t pressed = s_debounced[w];
+        // 长按/连发只在本次采样仍接触时计时（与原状态机相同，释放消抖期间不再触发连发）
+        uint32_t work = toggle | (pressed & raw[w]);
+
+        while (work != 0U) {
+            uint32_t b = (uint32_t)__builtin_ctz(work); // 最低位的置位按键
+            uint32_t bit = 1UL << b;
+            work &= work - 1U;
+            key_timer_step_isr(((uint32_t)w << 5) + b, (toggle & bit) != 0U, (pressed & bit) != 0U, now);
+        }
+    }
+
+#if (MATRIX_DELTA_EVENTS)
+    push_delta_isr();
+#endif
 
-        // 3. 恢复（拉低）当前行
-        HAL_GPIO_WritePin(ROW_Port[r], ROW_Pin[r], GPIO_PIN_RESET);
-    } // end of row loop
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+    // 无任何按下/消抖中的按键持续 KEY_IDLE_TIMEOUT_MS 后进入空闲（已空闲时环中剩余的快照不再计数）
+    uint32_t elapsed_ms = now - s_idle_tick_ms;
+    s_idle_tick_ms = now;
+    if (s_idle) return;
 
-    return event_count;
+    uint32_t active = 0;
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+        active |= raw[w] | s_debounced[w] | s_lock_bits[w] | unreported_bits(w);
+    }
+    if (active != 0U) {
+        s_idle_ms = 0;
+    } else if ((s_idle_ms += elapsed_ms) >= KEY_IDLE_TIMEOUT_MS) {
+        enter_idle_isr();
+    }
+#endif
 }
 
-// 在1kHz中断里运行的扫描例程：生成事件，推入队列
-void MatrixKeyboard_ScanStep_ISR(void)
+// 上半部：取快照环的写入槽，环满（下半部积压 RAW_RING_SIZE ms）时丢弃本次采样
+static inline RawSnapshot* raw_ring_slot_isr(void)
+{
+    // 每次周期累加一个扫描周期，丢弃的采样也计时
+    s_isr_tick_frac_us += s_scan_period_us;
+    while (s_isr_tick_frac_us >= 1000U) {
+        s_isr_tick_frac_us -= 1000U;
+        s_isr_tick_ms++;
+    }
+
+    uint8_t next_head = (uint8_t)((s_raw_head + 1U) & (RAW_RING_SIZE - 1U));
+    if (next_head == s_raw_tail) {
+        s_raw_overruns++;
+        return NULL;
+    }
+    RawSnapshot* slot = &s_raw_ring[s_raw_head];
+    slot->tick_ms = s_isr_tick_ms;
+    return slot;
+}
+
+// 上半部：发布快照并挂起PendSV
+static inline void raw_ring_commit_isr(void)
 {
-    s_isr_tick_ms++; // 每次周期+1ms
+    s_raw_ring[s_raw_head].time_us = Timebase_Micros();
+    __DMB(); // 快照内容先于写指针可见
+    s_raw_head = (uint8_t)((s_raw_head + 1U) & (RAW_RING_SIZE - 1U));
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
 
-    uint32_t now = s_isr_tick_ms;
+void MatrixKeyboard_BottomHalf_ISR(void)
+{
+    while (s_raw_tail != s_raw_head) {
+        __DMB(); // 先看到写指针，再读快照内容
+        process_snapshot(&s_raw_ring[s_raw_tail]);
+        s_raw_tail = (uint8_t)((s_raw_tail + 1U) & (RAW_RING_SIZE - 1U));
+    }
+}
 
+// CPU逐行扫描一帧：按行读取整个列端口生成原始位图
+static void scan_matrix_cpu(uint32_t* raw)
+{
     for (uint8_t r = 0; r < ROW_NUM; r++) {
         // 直接寄存器：拉高当前行
         ROW_Port[r]->BSRR = ROW_Pin[r];
 
-        for (uint8_t c = 0; c < COL_NUM; c++) {
-            if (Key_Map[r][c] == 0x00) continue;
-            // 直接寄存器：读取列状态
-            uint8_t is_pressed = ((COL_Port[c]->IDR & COL_Pin[c]) != 0U);
-
-            switch (s_key_fsm[r][c].state) {
-                case STATE_IDLE:
-                    if (is_pressed) {
-                        s_key_fsm[r][c].state = STATE_DEBOUNCE;
-                        s_int_cnt[r][c] = 0;
-                        s_key_fsm[r][c].timer = now;
-                    }
-                    break;
-                case STATE_DEBOUNCE:
-                    if (is_pressed) {
-                        if (s_int_cnt[r][c] < 255) s_int_cnt[r][c]++;
-                        if (s_int_cnt[r][c] >= INT_PRESS_THRESH) {
-                            s_key_fsm[r][c].state = STATE_PRESSED;
-                            s_key_fsm[r][c].timer = now;
-                            push_event_isr(r, c, KEY_EVENT_PRESS);
-                        }
-                    } else {
-                        if (s_int_cnt[r][c] > 0) s_int_cnt[r][c]--;
-                        if (s_int_cnt[r][c] == 0) {
-                            s_key_fsm[r][c].state = STATE_IDLE;
-                        }
-                    }
-                    break;
-                case STATE_PRESSED:
-                    if (is_pressed) {
-                        if (now - s_key_fsm[r][c].timer >= KEY_LONG_PRESS_TIME) {
-                            s_key_fsm[r][c].state = STATE_LONG_PRESS;
-                            s_key_fsm[r][c].timer = now;
-                            push_event_isr(r, c, KEY_EVENT_LONG_PRESS);
-                        }
-                    } else {
-                        if (s_int_cnt[r][c] > 0) s_int_cnt[r][c]--;
-                        if (s_int_cnt[r][c] <= INT_RELEASE_THRESH) {
-                            s_key_fsm[r][c].state = STATE_IDLE;
-                            push_event_isr(r, c, KEY_EVENT_RELEASE);
-                        }
-                    }
-                    break;
-                case STATE_LONG_PRESS:
-                    if (is_pressed) {
-                        if (now - s_key_fsm[r][c].timer >= KEY_REPEAT_INTERVAL) {
-                            s_key_fsm[r][c].timer = now;
-                            push_event_isr(r, c, KEY_EVENT_REPEAT);
-                        }
-                    } else {
-                        if (s_int_cnt[r][c] > 0) s_int_cnt[r][c]--;
-                        if (s_int_cnt[r][c] <= INT_RELEASE_THRESH) {
-                            s_key_fsm[r][c].state = STATE_IDLE;
-                            push_event_isr(r, c, KEY_EVENT_RELEASE);
-                        }
-                    }
-                    break;
-            }
-        }
+        MatrixRowBits bits = read_cols_isr() & s_valid_bits[r];
 
         // 直接寄存器：拉低当前行
         ROW_Port[r]->BSRR = ((uint32_t)ROW_Pin[r] << 16);
+
+        put_row_bits(raw, r, bits);
+    }
+}
+
+// 在1kHz中断里运行的扫描上半部：只采集原始位图写入快照环（DMA方式下仅用于唤醒时立即采样一次）
+void MatrixKeyboard_ScanStep_ISR(void)
+{
+    RawSnapshot* slot = raw_ring_slot_isr();
+    if (slot == NULL) return;
+
+    memset(slot->any, 0, sizeof(slot->any));
+    scan_matrix_cpu(slot->any);
+    memcpy(slot->all, slot->any, sizeof(slot->all));
+    raw_ring_commit_isr();
+}
+
+#if (MATRIX_SCAN_DMA)
+// 把一个列端口IDR采样打包成列位图
+static inline MatrixRowBits pack_cols(uint32_t idr)
+{
+    MatrixRowBits bits = 0;
+
+    for (uint8_t c = 0; c < COL_NUM; c++) {
+        bits |= (MatrixRowBits)((idr & COL_Pin[c]) != 0U) << c;
     }
-}
\ No newline at end of file
+    return bits;
+}
+
+// DMA上半部：把一个半区（1ms）内的 SCAN_DMA_FRAMES 帧归并为"任一帧按下/所有帧按下"两张位图，
+// 由下半部合并为一次消抖采样，使各消抖/计时参数仍以ms计
+static void scan_dma_frames_isr(const uint16_t* samples)
+{
+    RawSnapshot* slot = raw_ring_slot_isr();
+    if (slot == NULL) return;
+
+    memset(slot->any, 0, sizeof(slot->any));
+    memset(slot->all, 0xFF, sizeof(slot->all));
+    for (uint8_t f = 0; f < SCAN_DMA_FRAMES; f++) {
+        uint32_t frame[MATRIX_WORDS] = {0};
+        for (uint8_t r = 0; r < ROW_NUM; r++) {
+            put_row_bits(frame, r, pack_cols(samples[f * ROW_NUM + r]) & s_valid_bits[r]);
+        }
+        for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+            slot->any[w] |= frame[w];
+            slot->all[w] &= frame[w];
+        }
+    }
+    raw_ring_commit_isr();
+}
+
+static void scan_dma_half_isr(DMA_HandleTypeDef* hdma)
+{
+    (void)hdma;
+    scan_dma_frames_isr(&s_col_samples[0]);
+}
+
+static void scan_dma_full_isr(DMA_HandleTypeDef* hdma)
+{
+    (void)hdma;
+    scan_dma_frames_isr(&s_col_samples[SCAN_DMA_SAMPLES / 2]);
+}
+#endif
+
+// 启动周期扫描：TIM3中断，或TIM1 + DMA2（每次都从第0行、缓冲区起点重新对齐）
+static void scan_timer_start(void)
+{
+#if (MATRIX_SCAN_DMA)
+    // 第0行由CPU预先选中，DMA图样从第1行开始：CC1在周期中点采样，更新事件换到下一行
+    ROW_Port[0]->BSRR = s_row_bsrr[ROW_NUM - 1];
+
+    hdma_tim1_ch1.XferHalfCpltCallback = scan_dma_half_isr;
+    hdma_tim1_ch1.XferCpltCallback = scan_dma_full_isr;
+    HAL_DMA_Start(&hdma_tim1_up, (uint32_t)s_row_bsrr, (uint32_t)&ROW_Port[0]->BSRR, ROW_NUM);
+    HAL_DMA_Start_IT(&hdma_tim1_ch1, (uint32_t)&s_col_ports[0]->IDR, (uint32_t)s_col_samples, SCAN_DMA_SAMPLES);
+
+    __HAL_TIM_SET_COUNTER(&htim1, 0);
+    __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE | TIM_FLAG_CC1);
+    __HAL_TIM_ENABLE_DMA(&htim1, TIM_DMA_UPDATE | TIM_DMA_CC1);
+    __HAL_TIM_ENABLE(&htim1);
+#else
+    __HAL_TIM_SET_COUNTER(&htim3, 0);
+    HAL_TIM_Base_Start_IT(&htim3);
+#endif
+}
+
+static void scan_timer_stop(void)
+{
+#if (MATRIX_SCAN_DMA)
+    __HAL_TIM_DISABLE_DMA(&htim1, TIM_DMA_UPDATE | TIM_DMA_CC1);
+    __HAL_TIM_DISABLE(&htim1);
+    HAL_DMA_Abort(&hdma_tim1_up);
+    HAL_DMA_Abort(&hdma_tim1_ch1);
+    for (uint8_t r = 0; r < ROW_NUM; r++) {
+        ROW_Port[r]->BSRR = ((uint32_t)ROW_Pin[r] << 16);
+    }
+#else
+    HAL_TIM_Base_Stop_IT(&htim3);
+#endif
+}
+
+void MatrixKeyboard_EXTI_ISR(uint16_t GPIO_Pin)
+{
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+    if (!s_idle || (GPIO_Pin & s_col_exti_mask) == 0U) return;
+
+    EXTI->IMR &= ~(uint32_t)s_col_exti_mask;
+    EXTI->PR = s_col_exti_mask;
+    for (uint8_t r = 0; r < ROW_NUM; r++) {
+        ROW_Port[r]->BSRR = ((uint32_t)ROW_Pin[r] << 16);
+    }
+    s_idle = false;
+
+    // 立即扫描一次，唤醒按键不必等待下一个扫描周期
+    MatrixKeyboard_ScanStep_ISR();
+    scan_timer_start();
+#else
+    (void)GPIO_Pin;
+#endif
+}
+
+bool MatrixKeyboard_Sleep(void)
+{
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+    // 与下半部互斥：进入空闲的过程不能与PendSV中的超时进入交错
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // 消抖后仍有按住的键时不进入，避免释放事件被冻结到唤醒之后
+    uint32_t pressed = 0;
+    for (uint8_t w = 0; w < MATRIX_WORDS; w++) {
+        pressed |= s_debounced[w];
+    }
+    if (!s_idle && pressed == 0U) {
+        enter_idle_isr();
+    }
+    __set_PRIMASK(primask);
+    return s_idle;
+#else
+    return false;
+#endif
+}
+
+bool MatrixKeyboard_IsIdle(void)
+{
+#if (KEY_IDLE_TIMEOUT_MS > 0)
+    return s_idle;
+#else
+    return false;
+#endif
+}
+
+bool MatrixKeyboard_SetDebounceMode(uint8_t mode)
+{
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK)
+    return mode == DEBOUNCE_EAGER_PK;
+#else
+    if (mode != DEBOUNCE_SYM_DEFER && mode != DEBOUNCE_ASYM_EAGER) return false;
+    s_debounce_req = mode;
+    return true;
+#endif
+}
+
+uint8_t MatrixKeyboard_GetDebounceMode(void)
+{
+#if (MATRIX_DEBOUNCE_MODE == DEBOUNCE_EAGER_PK)
+    return DEBOUNCE_EAGER_PK;
+#else
+    return s_debounce_req;
+#endif
+}
+
+bool MatrixKeyboard_SetScanRate(uint16_t hz)
+{
+#if (MATRIX_SCAN_DMA)
+    (void)hz;
+    return false;
+#else
+    if (hz < MATRIX_SCAN_RATE_MIN_HZ || hz > MATRIX_SCAN_RATE_MAX_HZ) return false;
+
+    // TIM3计数频率1MHz；ARR不带预装载，计数值已超过新周期时从0重新计数，避免绕满16位
+    uint32_t period_us = 1000000UL / hz;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_scan_period_us = period_us;
+    __HAL_TIM_SET_AUTORELOAD(&htim3, period_us - 1U);
+    if (__HAL_TIM_GET_COUNTER(&htim3) >= period_us) {
+        __HAL_TIM_SET_COUNTER(&htim3, 0);
+    }
+    __set_PRIMASK(primask);
+    return true;
+#endif
+}
+
+uint16_t MatrixKeyboard_GetScanRate(void)
+{
+#if (MATRIX_SCAN_DMA)
+    return MATRIX_SCAN_HZ;
+#else
+    return (uint16_t)(1000000UL / s_scan_period_us);
+#endif
+}
+
+uint32_t MatrixKeyboard_GetScanOverruns(void)
+{
+    return s_raw_overruns;
+}
@@ -22,6 +22,9 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "matrix_keyboard.h"
+#include "timebase.h"
+#include "ws2812.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -60,7 +63,9 @@ extern TIM_HandleTypeDef htim3;
 extern TIM_HandleTypeDef htim4;
 extern DMA_HandleTypeDef hdma_tim4_ch1;
 /* USER CODE BEGIN EV */
-
+#if (MATRIX_SCAN_DMA)
+extern DMA_HandleTypeDef hdma_tim1_ch1;
+#endif
 /* USER CODE END EV */
 
 /******************************************************************************/
@@ -173,7 +178,7 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+  MatrixKeyboard_BottomHalf_ISR();
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
 
@@ -190,6 +195,8 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  Timebase_Poll();
+  WS2812_FrameTick();
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -233,6 +240,28 @@ void DMA1_Stream0_IRQHandler(void)
   HAL_DMA_IRQHandler(&hdma_tim4_ch1);
 }
 
+#if (MATRIX_SCAN_DMA)
+/* 矩阵DMA扫描：列采样半满/全满 */
+void DMA2_Stream1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_tim1_ch1);
+}
+#endif
+
+/* 矩阵列线 PA4 空闲唤醒 */
+void EXTI4_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_4);
+}
+
+/* 矩阵列线 PA5~PA7 空闲唤醒 */
+void EXTI9_5_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_5);
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_6);
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_7);
+}
+
 /* USER CODE END 1 */
 
 /**
@@ -249,6 +278,22 @@ void OTG_FS_IRQHandler(void)
   /* USER CODE END OTG_FS_IRQn 1 */
 }
 
+/**
+  * @brief This function handles USB On The Go FS Wakeup through EXTI line interrupt.
+  */
+void OTG_FS_WKUP_IRQHandler(void)
+{
+  /* USER CODE BEGIN OTG_FS_WKUP_IRQn 0 */
+  /* The system clock is restored by the main loop before interrupts are
+     re-enabled after STOP mode, see USB_Power_Process in main.c */
+  /* USER CODE END OTG_FS_WKUP_IRQn 0 */
+  __HAL_PCD_UNGATE_PHYCLOCK(&hpcd_USB_OTG_FS);
+  HAL_PCD_WKUP_IRQHandler(&hpcd_USB_OTG_FS);
+  /* USER CODE BEGIN OTG_FS_WKUP_IRQn 1 */
+
+  /* USER CODE END OTG_FS_WKUP_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
@@ -0,0 +1,43 @@
+#include "timebase.h"
+
+static uint32_t s_cycles_per_us = 1;
+static uint32_t s_last_cyccnt = 0; // 上次读到的CYCCNT
+static uint32_t s_wraps = 0;       // 回绕次数（64位计数的高32位）
+
+void Timebase_Init(void)
+{
+    s_cycles_per_us = SystemCoreClock / 1000000U;
+    if (s_cycles_per_us == 0U) s_cycles_per_us = 1;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    s_last_cyccnt = 0;
+    s_wraps = 0;
+}
+
+uint64_t Timebase_Cycles(void)
+{
+    // 读计数与更新回绕状态必须原子完成，否则高优先级中断可能插入并重复计入一次回绕
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t now = DWT->CYCCNT;
+    if (now < s_last_cyccnt) s_wraps++;
+    s_last_cyccnt = now;
+    uint64_t cycles = ((uint64_t)s_wraps << 32) | now;
+
+    __set_PRIMASK(primask);
+    return cycles;
+}
+
+uint64_t Timebase_Micros(void)
+{
+    return Timebase_Cycles() / s_cycles_per_us;
+}
+
+void Timebase_Poll(void)
+{
+    (void)Timebase_Cycles();
+}
@@ -10,7 +10,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "ws2812.h"
 #include "tim.h"
-#include <math.h>
+#include "timebase.h"
+#include "led_math.h"
+#include <string.h>
 
 // WS2812 时序参数 (基于84MHz APB1时钟，预分频器=0，周期=104)
 // 0码: 高电平约0.4us，低电平约0.85us
@@ -22,30 +24,119 @@
 #define WS2812_BITS_PER_LED 24
 #define WS2812_RESET_BITS 50  // 复位信号需要的低电平位数
 
-// DMA缓冲区大小
+#if (WS2812_DMA_STREAM)
+#if (WS2812_STREAM_LEDS < 2) || (WS2812_STREAM_LEDS % 2) != 0
+#error "WS2812_STREAM_LEDS must be even and at least 2"
+#endif
+// 流式发送：乒乓缓冲区每一半为一组LED；一帧先发送全部LED组，再发送足够覆盖复位时间的全零组
+#define WS2812_STREAM_HALF_LEDS    (WS2812_STREAM_LEDS / 2)
+#define WS2812_STREAM_HALF_WORDS   (WS2812_STREAM_HALF_LEDS * WS2812_BITS_PER_LED / 2)
+#define WS2812_STREAM_DATA_HALVES  ((WS2812_LED_NUM + WS2812_STREAM_HALF_LEDS - 1) / WS2812_STREAM_HALF_LEDS)
+#define WS2812_STREAM_RESET_HALVES ((WS2812_RESET_BITS + WS2812_STREAM_HALF_LEDS * WS2812_BITS_PER_LED - 1) / \
+                                    (WS2812_STREAM_HALF_LEDS * WS2812_BITS_PER_LED))
+
+// DMA缓冲区大小（半字数；DMA以半字写入16位的TIM4->CCR1）
+#define WS2812_DMA_BUFFER_SIZE (WS2812_STREAM_LEDS * WS2812_BITS_PER_LED)
+#else
+// DMA缓冲区大小（半字数；DMA以半字写入16位的TIM4->CCR1）
 #define WS2812_DMA_BUFFER_SIZE (WS2812_LED_NUM * WS2812_BITS_PER_LED + WS2812_RESET_BITS)
+#endif
+
+#if (WS2812_RESET_BITS % 2) != 0
+#error "WS2812_RESET_BITS must be even: the DMA buffer is filled with word stores"
+#endif
+
+// 编码查找表：颜色字节 -> 8个比较值（高位在前），每两个半字打包为一个字（小端，先发送的在低半字），
+// 编码时每字节只需4次字写入。表由宏在编译期生成，位于Flash，共4KB。
+#define WS2812_BIT(b, n)  ((((b) >> (n)) & 1U) ? WS2812_1_CODE : WS2812_0_CODE)
+#define WS2812_PAIR(b, n) ((uint32_t)WS2812_BIT(b, n) | ((uint32_t)WS2812_BIT(b, (n) - 1) << 16))
+#define WS2812_LUT1(b)    { WS2812_PAIR(b, 7), WS2812_PAIR(b, 5), WS2812_PAIR(b, 3), WS2812_PAIR(b, 1) }
+#define WS2812_LUT4(b)    WS2812_LUT1(b), WS2812_LUT1((b) + 1), WS2812_LUT1((b) + 2), WS2812_LUT1((b) + 3)
+#define WS2812_LUT16(b)   WS2812_LUT4(b), WS2812_LUT4((b) + 4), WS2812_LUT4((b) + 8), WS2812_LUT4((b) + 12)
+#define WS2812_LUT64(b)   WS2812_LUT16(b), WS2812_LUT16((b) + 16), WS2812_LUT16((b) + 32), WS2812_LUT16((b) + 48)
+
+static const uint32_t ws2812_bit_lut[256][4] = {
+    WS2812_LUT64(0), WS2812_LUT64(64), WS2812_LUT64(128), WS2812_LUT64(192)
+};
 
 /* Private variables ---------------------------------------------------------*/
 extern TIM_HandleTypeDef htim4;
 extern DMA_HandleTypeDef hdma_tim4_ch1;
 
-// DMA缓冲区
-static uint16_t ws2812_dma_buffer[WS2812_DMA_BUFFER_SIZE];
+// DMA缓冲区（按字存放，每字两个比较值）
+static uint32_t ws2812_dma_buffer[WS2812_DMA_BUFFER_SIZE / 2];
+
+// LED颜色帧缓冲 (GRB格式)，三缓冲：
+//   后台 ws2812_led_buffer：效果随时绘制，只由主循环访问；
+//   待发送 ws2812_pending_buffer：WS2812_Present() 与后台交换，只保留最新一帧；
+//   前台 ws2812_front_buffer：正在编码/发送，DMA空闲或上一帧发送完成时与待发送交换。
+// 前台发送期间不会被改写，因此没有撕裂；绘制不必等待DMA
+static uint8_t ws2812_frames[3][WS2812_LED_NUM * 3];
+static uint8_t *ws2812_led_buffer = ws2812_frames[0];
+static uint8_t *ws2812_pending_buffer = ws2812_frames[1];
+static uint8_t *ws2812_front_buffer = ws2812_frames[2];
+static volatile uint8_t ws2812_pending = 0;  // 待发送缓冲中有未发送的帧
 
-// LED颜色缓冲区 (GRB格式)
-static uint8_t ws2812_led_buffer[WS2812_LED_NUM * 3];
+static volatile uint32_t ws2812_frames_presented = 0;  // 已开始发送的帧数
+static volatile uint32_t ws2812_frames_dropped = 0;    // 发送前就被更新的帧替换掉的帧数
 
-// 更新标志
+// 更新标志：DMA正在发送（含排队等待的帧），由DMA中断在没有待发送帧时清除
 static volatile uint8_t ws2812_updating = 0;
 
+// 本帧的Num Lock指示色（GRB，已按亮度缩放），开始发送每帧时确定
+static uint8_t ws2812_indicator[3];
+static uint8_t ws2812_indicator_on = 0;
+
+#if (WS2812_DMA_STREAM)
+static volatile uint16_t ws2812_stream_sent = 0;  // 本帧已发送完的半缓冲区数
+#endif
+
+// 帧调度：SysTick中的 WS2812_FrameTick() 按 WS2812_FRAME_RATE_HZ 置位，WS2812_ProcessEffects() 每帧处理一次
+#if (WS2812_FRAME_RATE_HZ < 1) || (WS2812_FRAME_RATE_HZ > 1000)
+#error "WS2812_FRAME_RATE_HZ must be 1..1000"
+#endif
+static volatile uint8_t ws2812_frame_due = 0;
+static uint16_t ws2812_frame_phase = 0;   // 帧相位累加 (0~999)，每1ms加上帧率
+static uint8_t ws2812_dirty = 0;          // 后台缓冲自上次提交以来被改写过
+static uint8_t ws2812_skip_frames = 0;    // 上一帧超出预算后还要跳过的帧数
+
+// 灯效CPU时间统计（绘制 + 编码 + 提交）
+static uint64_t ws2812_effect_cycles = 0;
+static uint32_t ws2812_effect_max_us = 0;
+static uint32_t ws2812_over_budget = 0;
+
 // 模式管理变量
 static WS2812_Mode current_mode = WS2812_MODE_STATIC;
 static uint8_t brightness = 50;  // 0-100
-static uint32_t effect_timer = 0;
-static uint8_t effect_step = 0;
-
-// 按键状态跟踪
-static uint8_t key_press_time[5][4] = {0};  // 5行4列键盘
+static uint8_t brightness_scale = 127;  // brightness * 255 / 100，设置亮度时算好，绘制时只做乘法移位
+static uint32_t effect_timer = 0;    // 当前模式开始的时刻 (ms)，动画按经过的时间推进
+static uint32_t effect_step = 0;     // 上次绘制时的动画步数
+static uint8_t effect_restart = 1;   // 模式刚切换，下一帧必须绘制
+
+// 各动画每一步的时长 (ms) 与周期（步数）
+#define WS2812_BREATH_STEP_MS  20
+#define WS2812_BREATH_STEPS    63   // sin(step * 0.1) 约一个周期
+#define WS2812_BREATH_PHASE    1043 // 每步相位 0.1 rad（65536 = 2π）
+#define WS2812_RAINBOW_STEP_MS 50   // 每步色相 +5°
+#define WS2812_RAINBOW_STEPS   72
+#define WS2812_RAINBOW_PHASE   (65536U / WS2812_RAINBOW_STEPS)  // 每步色相相位（16位色相，65536 = 360°）
+#define WS2812_RAINBOW_LED     (65536U / WS2812_LED_NUM)       // 相邻LED色相差
+#define WS2812_FADE_STEP_MS    10
+#define WS2812_WAVE_STEP_MS    100
+#define WS2812_WAVE_STEPS      100
+#define WS2812_WAVE_PHASE      3129 // 每步相位 0.3 rad，相邻LED相差两步
+
+// 按键响应渐变：按LED存放剩余渐变步数（与矩阵尺寸无关）
+#define WS2812_FADE_STEPS 50
+#define WS2812_FADE_SCALE 1306  // 255 * 256 / WS2812_FADE_STEPS，剩余步数 * 该值 >> 8 得到亮度
+static uint8_t led_fade[WS2812_LED_NUM] = {0};
+
+// 主机下发的锁定键状态：在生成DMA数据时覆盖指示LED，不改动效果写入的颜色
+static volatile uint8_t lock_indicators = 0;
+static volatile uint8_t lock_indicators_changed = 0;
+
+// USB挂起期间熄灭全部LED（包括锁定键指示）
+static uint8_t ws2812_suspended = 0;
 
 // 预定义颜色
 const WS2812_Color WS2812_COLOR_RED = {255, 0, 0};
@@ -59,95 +150,140 @@ const WS2812_Color WS2812_COLOR_OFF = {0, 0, 0};
 
 // 内部函数声明
 static void apply_brightness(uint8_t *red, uint8_t *green, uint8_t *blue);
-static WS2812_Color hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val);
+static inline void ws2812_write_led(uint8_t *frame, uint16_t led, uint8_t red, uint8_t green, uint8_t blue);
 static uint8_t get_led_index_from_key(uint8_t row, uint8_t col);
+static void ws2812_encode_led(uint32_t *dst, const uint8_t *grb);
+static const uint8_t *ws2812_frame_led(uint16_t led);
+static void ws2812_start_next(void);
+#if (WS2812_DMA_STREAM)
+static void ws2812_stream_fill(uint32_t *dst, uint16_t group);
+static void ws2812_stream_next(uint8_t half);
+#endif
 
 /* Private function prototypes -----------------------------------------------*/
 
 /* Exported functions --------------------------------------------------------*/
 void WS2812_Init(void)
 {
-    // 清空LED缓冲区
-    for (int i = 0; i < WS2812_LED_NUM * 3; i++) {
-        ws2812_led_buffer[i] = 0;
-    }
+    // 清空LED帧缓冲
+    memset(ws2812_frames, 0, sizeof(ws2812_frames));
+    ws2812_pending = 0;
     
     // 清空DMA缓冲区
-    for (int i = 0; i < WS2812_DMA_BUFFER_SIZE; i++) {
+    for (int i = 0; i < WS2812_DMA_BUFFER_SIZE / 2; i++) {
         ws2812_dma_buffer[i] = 0;
     }
     
-    // 清空按键状态
-    for (int i = 0; i < 5; i++) {
-        for (int j = 0; j < 4; j++) {
-            key_press_time[i][j] = 0;
-        }
+    // 清空按键渐变状态
+    for (int i = 0; i < WS2812_LED_NUM; i++) {
+        led_fade[i] = 0;
     }
     
     ws2812_updating = 0;
     current_mode = WS2812_MODE_STATIC;
-    brightness = 50;
+    WS2812_SetBrightness(50);
     effect_timer = 0;
     effect_step = 0;
+    effect_restart = 1;
 }
 
-void WS2812_SetColor(uint8_t led_index, uint8_t red, uint8_t green, uint8_t blue)
+void WS2812_SetColor(uint16_t led_index, uint8_t red, uint8_t green, uint8_t blue)
 {
     if (led_index >= WS2812_LED_NUM) return;
     
     // 应用亮度调节
     apply_brightness(&red, &green, &blue);
-    
-    // WS2812使用GRB格式
-    ws2812_led_buffer[led_index * 3 + 0] = green;
-    ws2812_led_buffer[led_index * 3 + 1] = red;
-    ws2812_led_buffer[led_index * 3 + 2] = blue;
+    ws2812_write_led(ws2812_led_buffer, led_index, red, green, blue);
+    ws2812_dirty = 1;
 }
 
-void WS2812_SetColorStruct(uint8_t led_index, WS2812_Color color)
+void WS2812_SetColorStruct(uint16_t led_index, WS2812_Color color)
 {
     WS2812_SetColor(led_index, color.red, color.green, color.blue);
 }
 
-void WS2812_Update(void)
+void WS2812_Present(void)
 {
-    if (ws2812_updating) return;  // 防止并发更新
-    
+    uint8_t *frame = ws2812_led_buffer;
+    uint8_t start;
+    uint32_t primask = __get_PRIMASK();
+
+    ws2812_dirty = 0;
+
+    // 与DMA中断互斥：交换后台与待发送缓冲；DMA空闲时由这里开始发送
+    __disable_irq();
+    ws2812_led_buffer = ws2812_pending_buffer;
+    ws2812_pending_buffer = frame;
+    if (ws2812_pending) {
+        ws2812_frames_dropped++;
+    }
+    ws2812_pending = 1;
+    start = !ws2812_updating;
     ws2812_updating = 1;
-    
-    // 将LED数据转换为PWM数据
-    uint16_t dma_index = 0;
-    
-    for (int led = 0; led < WS2812_LED_NUM; led++) {
-        for (int byte = 0; byte < 3; byte++) {
-            uint8_t color_byte = ws2812_led_buffer[led * 3 + byte];
-            
-            // 从最高位开始发送
-            for (int bit = 7; bit >= 0; bit--) {
-                if (color_byte & (1 << bit)) {
-                    ws2812_dma_buffer[dma_index] = WS2812_1_CODE;
-                } else {
-                    ws2812_dma_buffer[dma_index] = WS2812_0_CODE;
-                }
-                dma_index++;
-            }
-        }
+    __set_PRIMASK(primask);
+
+    // 效果按像素增量绘制（如按键渐变），新的后台缓冲须从刚提交的帧继续；
+    // 中断只会交换指针，frame 在复制期间不会被改写
+    memcpy(ws2812_led_buffer, frame, WS2812_LED_NUM * 3);
+
+    if (start) {
+        ws2812_start_next();
     }
-    
-    // 添加复位信号
-    for (int i = 0; i < WS2812_RESET_BITS; i++) {
-        ws2812_dma_buffer[dma_index++] = 0;
+}
+
+void WS2812_Update(void)
+{
+    WS2812_Present();
+}
+
+uint32_t WS2812_GetPresentedFrames(void)
+{
+    return ws2812_frames_presented;
+}
+
+uint32_t WS2812_GetDroppedFrames(void)
+{
+    return ws2812_frames_dropped;
+}
+
+void WS2812_FrameTick(void)
+{
+    ws2812_frame_phase += WS2812_FRAME_RATE_HZ;
+    if (ws2812_frame_phase >= 1000U) {
+        ws2812_frame_phase -= 1000U;
+        ws2812_frame_due = 1;
     }
-    
-    // 启动DMA传输
-    HAL_TIM_PWM_Start_DMA(&htim4, TIM_CHANNEL_1, (uint32_t*)ws2812_dma_buffer, WS2812_DMA_BUFFER_SIZE);
+}
+
+uint32_t WS2812_GetEffectTimeUs(void)
+{
+    return (uint32_t)(ws2812_effect_cycles / (SystemCoreClock / 1000000U));
+}
+
+uint32_t WS2812_GetEffectMaxUs(void)
+{
+    return ws2812_effect_max_us;
+}
+
+uint32_t WS2812_GetOverBudgetFrames(void)
+{
+    return ws2812_over_budget;
 }
 
 void WS2812_DMAComplete(void)
 {
-    // 停止PWM输出
+#if (WS2812_DMA_STREAM)
+    // 乒乓缓冲区后一半发送完毕
+    ws2812_stream_next(1);
+#else
+    // 停止PWM输出，有排队的帧则紧接着发送
     HAL_TIM_PWM_Stop_DMA(&htim4, TIM_CHANNEL_1);
-    ws2812_updating = 0;
+    if (ws2812_pending) {
+        ws2812_start_next();
+    } else {
+        ws2812_updating = 0;
+    }
+#endif
 }
 
 // 模式管理函数
@@ -155,8 +291,9 @@ void WS2812_SetMode(WS2812_Mode mode)
 {
     if (mode < WS2812_MODE_COUNT) {
         current_mode = mode;
-        effect_timer = 0;
+        effect_timer = HAL_GetTick();
         effect_step = 0;
+        effect_restart = 1;
         
         // 根据模式初始化
         switch (mode) {
@@ -187,6 +324,7 @@ void WS2812_SetBrightness(uint8_t new_brightness)
 {
     if (new_brightness <= 100) {
         brightness = new_brightness;
+        brightness_scale = (uint8_t)(new_brightness * 255U / 100U);
     }
 }
 
@@ -210,9 +348,34 @@ void WS2812_SetAll(WS2812_Color color)
     }
 }
 
+// 按经过的时间计算动画步数（对 period 取模，period 为0表示不取模）；步数变化或模式刚切换时需要重绘
+static uint8_t effect_advance(uint32_t now_ms, uint32_t step_ms, uint32_t period)
+{
+    uint32_t step = (now_ms - effect_timer) / step_ms;
+
+    if (period != 0U) step %= period;
+    if (!effect_restart && step == effect_step) return 0;
+    effect_step = step;
+    effect_restart = 0;
+    return 1;
+}
+
 void WS2812_ProcessEffects(void)
 {
-    uint32_t current_time = HAL_GetTick();
+    uint32_t current_time;
+    uint64_t start_cycles;
+    uint32_t elapsed_us;
+
+    // 每帧只处理一次；挂起期间保持熄灭
+    if (!ws2812_frame_due || ws2812_suspended) return;
+    ws2812_frame_due = 0;
+    if (ws2812_skip_frames > 0) {
+        ws2812_skip_frames--;
+        return;
+    }
+
+    start_cycles = Timebase_Cycles();
+    current_time = HAL_GetTick();
     
     switch (current_mode) {
         case WS2812_MODE_OFF:
@@ -224,77 +387,122 @@ void WS2812_ProcessEffects(void)
             break;
             
         case WS2812_MODE_BREATHING:
-            if (current_time - effect_timer >= 20) {  // 每20ms更新一次
-                effect_timer = current_time;
-                
-                // 使用正弦波实现呼吸效果
-                float breath = (sin(effect_step * 0.1f) + 1.0f) * 0.5f;  // 0-1范围
-                uint8_t breath_brightness = (uint8_t)(breath * brightness);
-                
-                WS2812_Color breath_color = {breath_brightness * 255 / 100, 
-                                           breath_brightness * 255 / 100, 
-                                           breath_brightness * 255 / 100};
-                WS2812_SetAll(breath_color);
-                
-                effect_step++;
-                if (effect_step >= 63) effect_step = 0;  // 重置周期
+            if (effect_advance(current_time, WS2812_BREATH_STEP_MS, WS2812_BREATH_STEPS)) {
+                // 使用正弦波实现呼吸效果（查表，0-255范围）
+                uint8_t breath = LedMath_Sin8((uint16_t)(effect_step * WS2812_BREATH_PHASE));
+                uint8_t breath_brightness = LedMath_Scale8(breath, brightness_scale);
+                uint8_t v = LedMath_Scale8(breath_brightness, brightness_scale);  // 与 WS2812_SetAll() 相同再按亮度缩放一次
+                uint8_t *frame = ws2812_led_buffer;
+
+                for (int i = 0; i < WS2812_LED_NUM; i++) {
+                    ws2812_write_led(frame, i, v, v, v);
+                }
+                ws2812_dirty = 1;
             }
             break;
             
         case WS2812_MODE_RAINBOW:
-            if (current_time - effect_timer >= 50) {  // 每50ms更新一次
-                effect_timer = current_time;
-                
+            if (effect_advance(current_time, WS2812_RAINBOW_STEP_MS, WS2812_RAINBOW_STEPS)) {
+                uint16_t hue = (uint16_t)(effect_step * WS2812_RAINBOW_PHASE);
+                uint8_t *frame = ws2812_led_buffer;
+
                 for (int i = 0; i < WS2812_LED_NUM; i++) {
-                    uint16_t hue = (effect_step + i * 360 / WS2812_LED_NUM) % 360;
-                    WS2812_Color rainbow_color = hsv_to_rgb(hue, 255, brightness * 255 / 100);
-                    WS2812_SetColorStruct(i, rainbow_color);
+                    uint8_t r, g, b;
+
+                    LedMath_HsvToRgb((uint8_t)(hue >> 8), 255, brightness_scale, &r, &g, &b);
+                    apply_brightness(&r, &g, &b);
+                    ws2812_write_led(frame, i, r, g, b);
+                    hue = (uint16_t)(hue + WS2812_RAINBOW_LED);
                 }
-                
-                effect_step += 5;
-                if (effect_step >= 360) effect_step = 0;
+                ws2812_dirty = 1;
             }
             break;
             
-        case WS2812_MODE_KEY_REACTIVE:
+        case WS2812_MODE_KEY_REACTIVE: {
             // 按键响应模式在按键事件中处理
-            // 这里处理按键释放后的渐变效果
-            if (current_time - effect_timer >= 10) {
-                effect_timer = current_time;
-                
-                for (int r = 0; r < 5; r++) {
-                    for (int c = 0; c < 4; c++) {
-                        if (key_press_time[r][c] > 0) {
-                            key_press_time[r][c]--;
-                            uint8_t led_index = get_led_index_from_key(r, c);
-                            if (led_index < WS2812_LED_NUM) {
-                                uint8_t fade = key_press_time[r][c] * 255 / 50;  // 50步渐变
-                                WS2812_SetColor(led_index, fade, fade, fade);
-                            }
-                        }
+            // 这里处理按键释放后的渐变效果：按经过的步数一次补齐
+            uint32_t last_step = effect_step;
+
+            if (effect_advance(current_time, WS2812_FADE_STEP_MS, 0)) {
+                uint32_t steps = effect_step - last_step;
+                uint8_t *frame = ws2812_led_buffer;
+
+                // 三个通道相同：每个LED只做一次亮度缩放，直接写入帧缓冲
+                for (int i = 0; i < WS2812_LED_NUM; i++) {
+                    uint8_t left = led_fade[i];
+
+                    if (left > 0) {
+                        left = (left > steps) ? (uint8_t)(left - steps) : 0;
+                        led_fade[i] = left;
+                        uint8_t v = LedMath_Scale8((uint8_t)((left * WS2812_FADE_SCALE) >> 8), brightness_scale);
+                        ws2812_write_led(frame, i, v, v, v);
+                        ws2812_dirty = 1;
                     }
                 }
             }
             break;
+        }
             
         case WS2812_MODE_WAVE:
-            if (current_time - effect_timer >= 100) {  // 每100ms更新一次
-                effect_timer = current_time;
-                
+            if (effect_advance(current_time, WS2812_WAVE_STEP_MS, WS2812_WAVE_STEPS)) {
+                uint8_t *frame = ws2812_led_buffer;
+
                 for (int i = 0; i < WS2812_LED_NUM; i++) {
-                    float wave = sin((effect_step + i * 2) * 0.3f);
-                    uint8_t wave_brightness = (uint8_t)((wave + 1.0f) * 0.5f * brightness * 255 / 100);
-                    WS2812_SetColor(i, 0, wave_brightness, wave_brightness);
+                    uint8_t wave = LedMath_Sin8((uint16_t)((effect_step + i * 2) * WS2812_WAVE_PHASE));
+                    uint8_t v = LedMath_Scale8(LedMath_Scale8(wave, brightness_scale), brightness_scale);
+                    ws2812_write_led(frame, i, 0, v, v);
                 }
-                
-                effect_step++;
-                if (effect_step >= 100) effect_step = 0;
+                ws2812_dirty = 1;
             }
             break;
             
         default:
             break;
     }
+
+    // 只在帧缓冲被改写或锁定键状态变化时提交（指示色在开始发送时叠加）
+    if (ws2812_dirty || lock_indicators_changed) {
+        lock_indicators_changed = 0;
+        WS2812_Present();
+    }
+
+    // 统计本帧CPU时间；超出预算时跳过随后的帧，使灯效平均占用不超过 预算/帧周期
+    uint64_t elapsed = Timebase_Cycles() - start_cycles;
+    ws2812_effect_cycles += elapsed;
+    elapsed_us = (uint32_t)(elapsed / (SystemCoreClock / 1000000U));
+    if (elapsed_us > ws2812_effect_max_us) ws2812_effect_max_us = elapsed_us;
+    if (elapsed_us > WS2812_FRAME_BUDGET_US) {
+        uint32_t skip = (elapsed_us + WS2812_FRAME_BUDGET_US - 1) / WS2812_FRAME_BUDGET_US - 1;
+        ws2812_over_budget++;
+        ws2812_skip_frames = (skip > 255U) ? 255U : (uint8_t)skip;
+    }
+}
+
+void WS2812_Suspend(void)
+{
+    // 等当前帧（及排队的帧）发完，再发送一帧全黑；帧结束时DMA完成回调会停止TIM4
+    while (ws2812_updating) {}
+
+    ws2812_suspended = 1;
+    memset(ws2812_led_buffer, 0, WS2812_LED_NUM * 3);
+    WS2812_Present();
+
+    while (ws2812_updating) {}
+}
+
+void WS2812_Resume(void)
+{
+    ws2812_suspended = 0;
+
+    // 重新按当前模式绘制（静态模式不会自行刷新），并在下一次 ProcessEffects 中发送
+    WS2812_SetMode(current_mode);
+    lock_indicators_changed = 1;
+}
+
+void WS2812_SetLockIndicators(uint8_t leds)
+{
+    lock_indicators = leds;
+    lock_indicators_changed = 1;
 }
 
 // 按键响应函数
@@ -304,13 +512,15 @@ void WS2812_OnKeyPress(uint8_t row, uint8_t col)
         uint8_t led_index = get_led_index_from_key(row, col);
         if (led_index < WS2812_LED_NUM) {
             WS2812_SetColorStruct(led_index, WS2812_COLOR_WHITE);
-            key_press_time[row][col] = 50;  // 设置渐变时间
+            led_fade[led_index] = WS2812_FADE_STEPS;  // 设置渐变时间
         }
     }
 }
 
 void WS2812_OnKeyRelease(uint8_t row, uint8_t col)
 {
+    (void)row;
+    (void)col;
     if (current_mode == WS2812_MODE_KEY_REACTIVE) {
         // 开始渐变效果，在ProcessEffects中处理
     }
@@ -319,53 +529,119 @@ void WS2812_OnKeyRelease(uint8_t row, uint8_t col)
 // 内部函数实现
 static void apply_brightness(uint8_t *red, uint8_t *green, uint8_t *blue)
 {
-    *red = (*red * brightness) / 100;
-    *green = (*green * brightness) / 100;
-    *blue = (*blue * brightness) / 100;
+    *red = LedMath_Scale8(*red, brightness_scale);
+    *green = LedMath_Scale8(*green, brightness_scale);
+    *blue = LedMath_Scale8(*blue, brightness_scale);
 }
 
-static WS2812_Color hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val)
+// 按GRB顺序写入一个LED（颜色已按亮度缩放）；调用者负责置 ws2812_dirty
+static inline void ws2812_write_led(uint8_t *frame, uint16_t led, uint8_t red, uint8_t green, uint8_t blue)
 {
-    WS2812_Color rgb;
-    uint8_t region, remainder, p, q, t;
+    frame[led * 3 + 0] = green;
+    frame[led * 3 + 1] = red;
+    frame[led * 3 + 2] = blue;
+}
 
-    if (sat == 0) {
-        rgb.red = val;
-        rgb.green = val;
-        rgb.blue = val;
-        return rgb;
+// 本帧实际发送的颜色：Num Lock 指示LED由指示色覆盖
+static const uint8_t *ws2812_frame_led(uint16_t led)
+{
+    if (led == WS2812_NUM_LOCK_LED && ws2812_indicator_on) {
+        return ws2812_indicator;
     }
+    return &ws2812_front_buffer[led * 3];
+}
+
+// 待发送帧换到前台并开始发送。调用时DMA空闲且 ws2812_updating 已置位：
+// 要么在 WS2812_Present() 中（此时不会有DMA中断），要么在最高优先级的DMA中断中
+static void ws2812_start_next(void)
+{
+    uint8_t *frame = ws2812_front_buffer;
+
+    ws2812_front_buffer = ws2812_pending_buffer;
+    ws2812_pending_buffer = frame;
+    ws2812_pending = 0;
+    ws2812_frames_presented++;
+
+    // Num Lock 指示色（GRB），按当前亮度缩放
+    ws2812_indicator[0] = 255;
+    ws2812_indicator[1] = 0;
+    ws2812_indicator[2] = 0;
+    apply_brightness(&ws2812_indicator[1], &ws2812_indicator[0], &ws2812_indicator[2]);
+    ws2812_indicator_on = (lock_indicators & WS2812_LOCK_NUM) && !ws2812_suspended;
+
+#if (WS2812_DMA_STREAM)
+    // 先填满乒乓缓冲区的两半，其余LED在DMA半满/全满中断中编码
+    ws2812_stream_sent = 0;
+    ws2812_stream_fill(&ws2812_dma_buffer[0], 0);
+    ws2812_stream_fill(&ws2812_dma_buffer[WS2812_STREAM_HALF_WORDS], 1);
+#else
+    // 将LED数据转换为PWM数据：每个颜色字节查表得到8个比较值
+    uint32_t *dst = ws2812_dma_buffer;
 
-    region = hue / 43;
-    remainder = (hue - (region * 43)) * 6;
+    for (int led = 0; led < WS2812_LED_NUM; led++) {
+        ws2812_encode_led(dst, ws2812_frame_led(led));
+        dst += WS2812_BITS_PER_LED / 2;
+    }
+    
+    // 添加复位信号
+    for (int i = 0; i < WS2812_RESET_BITS / 2; i++) {
+        *dst++ = 0;
+    }
+#endif
+    
+    // 启动DMA传输
+    HAL_TIM_PWM_Start_DMA(&htim4, TIM_CHANNEL_1, ws2812_dma_buffer, WS2812_DMA_BUFFER_SIZE);
+}
 
-    p = (val * (255 - sat)) >> 8;
-    q = (val * (255 - ((sat * remainder) >> 8))) >> 8;
-    t = (val * (255 - ((sat * (255 - remainder)) >> 8))) >> 8;
+// 编码一个LED（GRB三字节）为24个比较值，写入12个字
+static void ws2812_encode_led(uint32_t *dst, const uint8_t *grb)
+{
+    for (int byte = 0; byte < 3; byte++) {
+        const uint32_t *code = ws2812_bit_lut[grb[byte]];
+        dst[0] = code[0];
+        dst[1] = code[1];
+        dst[2] = code[2];
+        dst[3] = code[3];
+        dst += 4;
+    }
+}
 
-    switch (region) {
-        case 0:
-            rgb.red = val; rgb.green = t; rgb.blue = p;
-            break;
-        case 1:
-            rgb.red = q; rgb.green = val; rgb.blue = p;
-            break;
-        case 2:
-            rgb.red = p; rgb.green = val; rgb.blue = t;
-            break;
-        case 3:
-            rgb.red = p; rgb.green = q; rgb.blue = val;
-            break;
-        case 4:
-            rgb.red = t; rgb.green = p; rgb.blue = val;
-            break;
-        default:
-            rgb.red = val; rgb.green = p; rgb.blue = q;
-            break;
+#if (WS2812_DMA_STREAM)
+// 编码第group组LED填入半个乒乓缓冲区；超出LED数量的部分填0（复位低电平）
+static void ws2812_stream_fill(uint32_t *dst, uint16_t group)
+{
+    for (uint16_t i = 0; i < WS2812_STREAM_HALF_LEDS; i++) {
+        uint16_t led = group * WS2812_STREAM_HALF_LEDS + i;
+
+        if (led < WS2812_LED_NUM) {
+            ws2812_encode_led(dst, ws2812_frame_led(led));
+        } else {
+            for (int w = 0; w < WS2812_BITS_PER_LED / 2; w++) {
+                dst[w] = 0;
+            }
+        }
+        dst += WS2812_BITS_PER_LED / 2;
     }
+}
 
-    return rgb;
+// DMA中断：half这一半刚发送完（另一半正在发送），填入下一组；全部LED与复位组发完后停止
+static void ws2812_stream_next(uint8_t half)
+{
+    uint16_t sent = ++ws2812_stream_sent;
+
+    if (sent >= WS2812_STREAM_DATA_HALVES + WS2812_STREAM_RESET_HALVES) {
+        HAL_TIM_PWM_Stop_DMA(&htim4, TIM_CHANNEL_1);
+        if (ws2812_pending) {
+            ws2812_start_next();
+        } else {
+            ws2812_updating = 0;
+        }
+        return;
+    }
+    // 另一半中是第 sent 组，这一半接着放第 sent + 1 组
+    ws2812_stream_fill(&ws2812_dma_buffer[half * WS2812_STREAM_HALF_WORDS], sent + 1U);
 }
+#endif
 
 static uint8_t get_led_index_from_key(uint8_t row, uint8_t col)
 {
@@ -386,4 +662,14 @@ void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim)
     }
 }
 
+#if (WS2812_DMA_STREAM)
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim->Instance == TIM4) {
+        // 乒乓缓冲区前一半发送完毕
+        ws2812_stream_next(0);
+    }
+}
+#endif
+
 /* USER CODE END 1 */
\ No newline at end of file
@@ -43,11 +43,60 @@ extern "C" {
 #ifndef HID_EPIN_ADDR
 #define HID_EPIN_ADDR                              0x81U
 #endif /* HID_EPIN_ADDR */
-#define HID_EPIN_SIZE                              0x08U
+#define HID_EPIN_SIZE                              0x08U   /* boot keyboard */
 
-#define USB_HID_CONFIG_DESC_SIZ                    34U
+#define HID_EPOUT_ADDR                             0x01U
+#define HID_EPOUT_SIZE                             0x08U   /* keyboard LED output report */
+
+#if (USBD_HID_KEYBOARD_ONLY == 1U)
+/* Boot keyboard interface only: EP2/EP3 are free for another function */
+#define HID_ITF_KEYBOARD                           0U
+#define HID_ITF_NUM                                1U
+
+#define USB_HID_CONFIG_DESC_SIZ                    41U
+#else
+#define HID_EXT_EPIN_ADDR                          0x82U
+#define HID_EXT_EPIN_SIZE                          0x20U   /* NKRO / consumer / system control */
+
+#define HID_RAW_EPIN_ADDR                          0x83U
+#define HID_RAW_EPOUT_ADDR                         0x03U
+#define HID_RAW_EP_SIZE                            0x40U   /* vendor raw HID, both directions */
+
+/* Interfaces of the configuration, one IN endpoint each */
+#define HID_ITF_KEYBOARD                           0U
+#define HID_ITF_EXTRA                              1U
+#define HID_ITF_RAW                                2U
+#define HID_ITF_NUM                                3U
+
+#define USB_HID_CONFIG_DESC_SIZ                    98U
+#endif /* USBD_HID_KEYBOARD_ONLY */
 #define USB_HID_DESC_SIZ                           9U
-#define HID_MOUSE_REPORT_DESC_SIZE                 63U
+#define HID_KEYBOARD_REPORT_DESC_SIZE              63U
+#define HID_EXTRA_REPORT_DESC_SIZE                 82U
+#define HID_RAW_REPORT_DESC_SIZE                   34U
+
+#define HID_REPORT_ID_NKRO                         1U
+#define HID_REPORT_ID_CONSUMER                     2U
+#define HID_REPORT_ID_SYSTEM                       3U
+
+#define HID_BOOT_REPORT_SIZE                       8U   /* modifiers, reserved, 6 key codes */
+#define HID_NKRO_REPORT_SIZE                       30U  /* report ID, modifiers, bitmap of usages 0x00-0xDF */
+#define HID_CONSUMER_REPORT_SIZE                   3U   /* report ID, 16-bit usage */
+#define HID_SYSTEM_REPORT_SIZE                     3U   /* report ID, 16-bit usage */
+
+/* LED output report bits (usage page 0x08, Num Lock .. Kana) */
+#define HID_LED_NUM_LOCK                           0x01U
+#define HID_LED_CAPS_LOCK                          0x02U
+#define HID_LED_SCROLL_LOCK                        0x04U
+#define HID_LED_COMPOSE                            0x08U
+#define HID_LED_KANA                               0x10U
+
+#define HID_REPORT_TYPE_INPUT                      0x01U
+#define HID_REPORT_TYPE_OUTPUT                     0x02U
+#define HID_REPORT_TYPE_FEATURE                    0x03U
+
+#define HID_PROTOCOL_BOOT                          0U
+#define HID_PROTOCOL_REPORT                        1U
 
 #define HID_DESCRIPTOR_TYPE                        0x21U
 #define HID_REPORT_DESC                            0x22U
@@ -57,9 +106,13 @@ extern "C" {
 #endif /* HID_HS_BINTERVAL */
 
 #ifndef HID_FS_BINTERVAL
-#define HID_FS_BINTERVAL                           0x0AU
+#define HID_FS_BINTERVAL                           0x01U
 #endif /* HID_FS_BINTERVAL */
 
+#ifndef HID_REPORT_QUEUE_SIZE
+#define HID_REPORT_QUEUE_SIZE                      8U   /* power of 2 */
+#endif /* HID_REPORT_QUEUE_SIZE */
+
 #define HID_REQ_SET_PROTOCOL                       0x0BU
 #define HID_REQ_GET_PROTOCOL                       0x03U
 
@@ -68,6 +121,7 @@ extern "C" {
 
 #define HID_REQ_SET_REPORT                         0x09U
 #define HID_REQ_GET_REPORT                         0x01U
+
 /**
   * @}
   */
@@ -85,10 +139,37 @@ typedef enum
 
 typedef struct
 {
-  uint32_t Protocol;
-  uint32_t IdleState;
-  uint32_t AltSetting;
   HID_StateTypeDef state;
+  uint8_t *Queue;                      /* HID_REPORT_QUEUE_SIZE entries of Size bytes */
+  uint8_t *ReportLast;                 /* last report armed, also the transmit buffer */
+  uint8_t QueueLen[HID_REPORT_QUEUE_SIZE];
+  uint8_t QueueHead;                   /* next report to arm, advanced by SOF/DataIn */
+  uint8_t QueueCount;
+  uint8_t ReportLastLen;
+  uint8_t EpAddr;
+  uint8_t Size;                        /* wMaxPacketSize of the endpoint */
+  uint8_t IdleRate;                    /* SET_IDLE duration in 4 ms units, 0: send on change only */
+  uint16_t IdleCount;                  /* SOF periods since the last report was sent */
+} USBD_HID_EpTypeDef;
+
+typedef struct
+{
+  uint32_t Protocol;                   /* boot keyboard interface only */
+  uint32_t AltSetting;
+  USBD_HID_EpTypeDef Ep[HID_ITF_NUM];  /* indexed by interface number */
+  uint8_t KbdQueue[HID_REPORT_QUEUE_SIZE][HID_EPIN_SIZE];
+  uint8_t KbdLast[HID_EPIN_SIZE];
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  uint8_t ExtQueue[HID_REPORT_QUEUE_SIZE][HID_EXT_EPIN_SIZE];
+  uint8_t ExtLast[HID_EXT_EPIN_SIZE];
+  uint8_t RawQueue[HID_REPORT_QUEUE_SIZE][HID_RAW_EP_SIZE];
+  uint8_t RawLast[HID_RAW_EP_SIZE];
+  uint8_t RawOut[HID_RAW_EP_SIZE];
+#endif /* USBD_HID_KEYBOARD_ONLY */
+  uint8_t LedOut[HID_EPOUT_SIZE];      /* interrupt OUT endpoint buffer */
+  uint8_t LedCtl[HID_EPOUT_SIZE];      /* SET_REPORT (Output) data stage buffer */
+  uint8_t LedState;                    /* last lock state set by the host */
+  uint8_t CtlRequest;                  /* class request whose EP0 data stage is pending */
 } USBD_HID_HandleTypeDef;
 
 /*
@@ -135,7 +216,13 @@ extern USBD_ClassTypeDef USBD_HID;
   * @{
   */
 uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *report, uint16_t len);
+uint8_t USBD_HID_SendReportItf(USBD_HandleTypeDef *pdev, uint8_t itf, uint8_t *report, uint16_t len);
+void USBD_HID_RawReceived(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t len);
+void USBD_HID_ReportSent(USBD_HandleTypeDef *pdev, uint8_t itf);
+void USBD_HID_LedStateChanged(USBD_HandleTypeDef *pdev, uint8_t leds);
+uint8_t USBD_HID_GetLedState(USBD_HandleTypeDef *pdev);
 uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev);
+uint8_t USBD_HID_GetProtocol(USBD_HandleTypeDef *pdev);
 
 /**
   * @}
@@ -24,11 +24,22 @@
   *           for Human Interface Devices (HID) Version 1.11 Jun 27, 2001".
   *           This driver implements the following aspects of the specification:
   *             - The Boot Interface Subclass
-  *             - The Mouse protocol
+  *             - The Keyboard protocol
   *             - Usage Page : Generic Desktop
-  *             - Usage : Joystick
+  *             - Usage : Keyboard
   *             - Collection : Application
   *
+  *           The configuration holds three HID interfaces, each with its own
+  *           interrupt IN endpoint and report queue:
+  *             - Interface 0: boot keyboard (EP1 IN)
+  *             - Interface 1: NKRO keyboard, consumer and system control,
+  *                            selected by report ID (EP2 IN)
+  *             - Interface 2: vendor raw HID, 64 bytes (EP3 IN / EP3 OUT)
+  *
+  *           With USBD_HID_KEYBOARD_ONLY only interface 0 is present and
+  *           keyboard reports always use the boot layout; EP2/EP3 are left
+  *           to another function of the device.
+  *
   * @note     In HS mode and when the DMA is used, all variables and data structures
   *           dealing with the DMA during the transaction process should be 32-bit aligned.
   *
@@ -91,11 +102,22 @@ static uint8_t USBD_HID_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
 static uint8_t USBD_HID_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
 static uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
 static uint8_t USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_HID_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev);
+static void USBD_HID_SetLedState(USBD_HandleTypeDef *pdev, USBD_HID_HandleTypeDef *hhid, uint8_t leds);
+static uint8_t USBD_HID_SOF(USBD_HandleTypeDef *pdev);
+static void USBD_HID_ArmNext(USBD_HandleTypeDef *pdev, USBD_HID_EpTypeDef *ep);
+static void USBD_HID_EpInit(USBD_HID_EpTypeDef *ep, uint8_t addr, uint8_t size,
+                            uint8_t *queue, uint8_t *last);
+static uint8_t USBD_HID_ReportsMergeable(uint8_t itf, const uint8_t *prev, const uint8_t *tail,
+                                         const uint8_t *next, uint16_t len);
+static uint8_t USBD_HID_ReportHasKey(const uint8_t *report, uint16_t len, uint8_t key);
 #ifndef USE_USBD_COMPOSITE
 static uint8_t *USBD_HID_GetFSCfgDesc(uint16_t *length);
 static uint8_t *USBD_HID_GetHSCfgDesc(uint16_t *length);
 static uint8_t *USBD_HID_GetOtherSpeedCfgDesc(uint16_t *length);
 static uint8_t *USBD_HID_GetDeviceQualifierDesc(uint16_t *length);
+static void USBD_HID_SetCfgDescInterval(uint8_t bInterval);
 #endif /* USE_USBD_COMPOSITE  */
 /**
   * @}
@@ -111,10 +133,10 @@ USBD_ClassTypeDef USBD_HID =
   USBD_HID_DeInit,
   USBD_HID_Setup,
   NULL,              /* EP0_TxSent */
-  NULL,              /* EP0_RxReady */
+  USBD_HID_EP0_RxReady, /* EP0_RxReady */
   USBD_HID_DataIn,   /* DataIn */
-  NULL,              /* DataOut */
-  NULL,              /* SOF */
+  USBD_HID_DataOut,  /* DataOut */
+  USBD_HID_SOF,      /* SOF */
   NULL,
   NULL,
 #ifdef USE_USBD_COMPOSITE
@@ -138,7 +160,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_CfgDesc[USB_HID_CONFIG_DESC_SIZ] __ALIGN_E
   USB_DESC_TYPE_CONFIGURATION,                        /* bDescriptorType: Configuration */
   USB_HID_CONFIG_DESC_SIZ,                            /* wTotalLength: Bytes returned */
   0x00,
-  0x01,                                               /* bNumInterfaces: 1 interface */
+  HID_ITF_NUM,                                        /* bNumInterfaces */
   0x01,                                               /* bConfigurationValue: Configuration value */
   0x00,                                               /* iConfiguration: Index of string descriptor
                                                          describing the configuration */
@@ -149,18 +171,18 @@ __ALIGN_BEGIN static uint8_t USBD_HID_CfgDesc[USB_HID_CONFIG_DESC_SIZ] __ALIGN_E
 #endif /* USBD_SELF_POWERED */
   USBD_MAX_POWER,                                     /* MaxPower (mA) */
 
-  /************** Descriptor of Joystick Mouse interface ****************/
+  /************** Descriptor of Keyboard interface ****************/
   /* 09 */
   0x09,                                               /* bLength: Interface Descriptor size */
   USB_DESC_TYPE_INTERFACE,                            /* bDescriptorType: Interface descriptor type */
-  0x00,                                               /* bInterfaceNumber: Number of Interface */
+  HID_ITF_KEYBOARD,                                   /* bInterfaceNumber: Number of Interface */
   0x00,                                               /* bAlternateSetting: Alternate setting */
-  0x01,                                               /* bNumEndpoints */
+  0x02,                                               /* bNumEndpoints */
   0x03,                                               /* bInterfaceClass: HID */
   0x01,                                               /* bInterfaceSubClass : 1=BOOT, 0=no boot */
   0x01,                                               /* nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse */
   0,                                                  /* iInterface: Index of string descriptor */
-  /******************** Descriptor of Joystick Mouse HID ********************/
+  /******************** Descriptor of Keyboard HID ********************/
   /* 18 */
   0x09,                                               /* bLength: HID Descriptor size */
   HID_DESCRIPTOR_TYPE,                                /* bDescriptorType: HID */
@@ -169,19 +191,97 @@ __ALIGN_BEGIN static uint8_t USBD_HID_CfgDesc[USB_HID_CONFIG_DESC_SIZ] __ALIGN_E
   0x00,                                               /* bCountryCode: Hardware target country */
   0x01,                                               /* bNumDescriptors: Number of HID class descriptors to follow */
   0x22,                                               /* bDescriptorType */
-  HID_MOUSE_REPORT_DESC_SIZE,                         /* wItemLength: Total length of Report descriptor */
+  HID_KEYBOARD_REPORT_DESC_SIZE,                      /* wItemLength: Total length of Report descriptor */
   0x00,
-  /******************** Descriptor of Mouse endpoint ********************/
+  /******************** Descriptor of Keyboard endpoint ********************/
   /* 27 */
   0x07,                                               /* bLength: Endpoint Descriptor size */
   USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
 
   HID_EPIN_ADDR,                                      /* bEndpointAddress: Endpoint Address (IN) */
   0x03,                                               /* bmAttributes: Interrupt endpoint */
-  HID_EPIN_SIZE,                                      /* wMaxPacketSize: 4 Bytes max */
+  HID_EPIN_SIZE,                                      /* wMaxPacketSize: 8 Bytes max */
   0x00,
   HID_FS_BINTERVAL,                                   /* bInterval: Polling Interval */
   /* 34 */
+  0x07,                                               /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
+  HID_EPOUT_ADDR,                                     /* bEndpointAddress: Endpoint Address (OUT) */
+  0x03,                                               /* bmAttributes: Interrupt endpoint */
+  HID_EPOUT_SIZE,                                     /* wMaxPacketSize: 8 Bytes max */
+  0x00,
+  HID_FS_BINTERVAL,                                   /* bInterval: Polling Interval */
+  /* 41 */
+
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  /************** Descriptor of NKRO / consumer / system interface ****************/
+  0x09,                                               /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,                            /* bDescriptorType: Interface descriptor type */
+  HID_ITF_EXTRA,                                      /* bInterfaceNumber: Number of Interface */
+  0x00,                                               /* bAlternateSetting: Alternate setting */
+  0x01,                                               /* bNumEndpoints */
+  0x03,                                               /* bInterfaceClass: HID */
+  0x00,                                               /* bInterfaceSubClass : 1=BOOT, 0=no boot */
+  0x00,                                               /* nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse */
+  0,                                                  /* iInterface: Index of string descriptor */
+  /* 50 */
+  0x09,                                               /* bLength: HID Descriptor size */
+  HID_DESCRIPTOR_TYPE,                                /* bDescriptorType: HID */
+  0x11,                                               /* bcdHID: HID Class Spec release number */
+  0x01,
+  0x00,                                               /* bCountryCode: Hardware target country */
+  0x01,                                               /* bNumDescriptors: Number of HID class descriptors to follow */
+  0x22,                                               /* bDescriptorType */
+  HID_EXTRA_REPORT_DESC_SIZE,                         /* wItemLength: Total length of Report descriptor */
+  0x00,
+  /* 59 */
+  0x07,                                               /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
+  HID_EXT_EPIN_ADDR,                                  /* bEndpointAddress: Endpoint Address (IN) */
+  0x03,                                               /* bmAttributes: Interrupt endpoint */
+  HID_EXT_EPIN_SIZE,                                  /* wMaxPacketSize: 32 Bytes max */
+  0x00,
+  HID_FS_BINTERVAL,                                   /* bInterval: Polling Interval */
+  /* 66 */
+
+  /************** Descriptor of raw HID interface ****************/
+  0x09,                                               /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,                            /* bDescriptorType: Interface descriptor type */
+  HID_ITF_RAW,                                        /* bInterfaceNumber: Number of Interface */
+  0x00,                                               /* bAlternateSetting: Alternate setting */
+  0x02,                                               /* bNumEndpoints */
+  0x03,                                               /* bInterfaceClass: HID */
+  0x00,                                               /* bInterfaceSubClass : 1=BOOT, 0=no boot */
+  0x00,                                               /* nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse */
+  0,                                                  /* iInterface: Index of string descriptor */
+  /* 75 */
+  0x09,                                               /* bLength: HID Descriptor size */
+  HID_DESCRIPTOR_TYPE,                                /* bDescriptorType: HID */
+  0x11,                                               /* bcdHID: HID Class Spec release number */
+  0x01,
+  0x00,                                               /* bCountryCode: Hardware target country */
+  0x01,                                               /* bNumDescriptors: Number of HID class descriptors to follow */
+  0x22,                                               /* bDescriptorType */
+  HID_RAW_REPORT_DESC_SIZE,                           /* wItemLength: Total length of Report descriptor */
+  0x00,
+  /* 84 */
+  0x07,                                               /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
+  HID_RAW_EPIN_ADDR,                                  /* bEndpointAddress: Endpoint Address (IN) */
+  0x03,                                               /* bmAttributes: Interrupt endpoint */
+  HID_RAW_EP_SIZE,                                    /* wMaxPacketSize: 64 Bytes max */
+  0x00,
+  HID_FS_BINTERVAL,                                   /* bInterval: Polling Interval */
+  /* 91 */
+  0x07,                                               /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
+  HID_RAW_EPOUT_ADDR,                                 /* bEndpointAddress: Endpoint Address (OUT) */
+  0x03,                                               /* bmAttributes: Interrupt endpoint */
+  HID_RAW_EP_SIZE,                                    /* wMaxPacketSize: 64 Bytes max */
+  0x00,
+  HID_FS_BINTERVAL,                                   /* bInterval: Polling Interval */
+  /* 98 */
+#endif /* USBD_HID_KEYBOARD_ONLY */
 };
 #endif /* USE_USBD_COMPOSITE  */
 
@@ -196,10 +296,39 @@ __ALIGN_BEGIN static uint8_t USBD_HID_Desc[USB_HID_DESC_SIZ] __ALIGN_END =
   0x00,                                               /* bCountryCode: Hardware target country */
   0x01,                                               /* bNumDescriptors: Number of HID class descriptors to follow */
   0x22,                                               /* bDescriptorType */
-  HID_MOUSE_REPORT_DESC_SIZE,                         /* wItemLength: Total length of Report descriptor */
+  HID_KEYBOARD_REPORT_DESC_SIZE,                    /* wItemLength: Total length of Report descriptor */
   0x00,
 };
 
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+/* HID descriptors of the NKRO / consumer / system and raw HID interfaces */
+__ALIGN_BEGIN static uint8_t USBD_HID_ExtDesc[USB_HID_DESC_SIZ] __ALIGN_END =
+{
+  0x09,                                               /* bLength: HID Descriptor size */
+  HID_DESCRIPTOR_TYPE,                                /* bDescriptorType: HID */
+  0x11,                                               /* bcdHID: HID Class Spec release number */
+  0x01,
+  0x00,                                               /* bCountryCode: Hardware target country */
+  0x01,                                               /* bNumDescriptors: Number of HID class descriptors to follow */
+  0x22,                                               /* bDescriptorType */
+  HID_EXTRA_REPORT_DESC_SIZE,                       /* wItemLength: Total length of Report descriptor */
+  0x00,
+};
+
+__ALIGN_BEGIN static uint8_t USBD_HID_RawDesc[USB_HID_DESC_SIZ] __ALIGN_END =
+{
+  0x09,                                               /* bLength: HID Descriptor size */
+  HID_DESCRIPTOR_TYPE,                                /* bDescriptorType: HID */
+  0x11,                                               /* bcdHID: HID Class Spec release number */
+  0x01,
+  0x00,                                               /* bCountryCode: Hardware target country */
+  0x01,                                               /* bNumDescriptors: Number of HID class descriptors to follow */
+  0x22,                                               /* bDescriptorType */
+  HID_RAW_REPORT_DESC_SIZE,                         /* wItemLength: Total length of Report descriptor */
+  0x00,
+};
+#endif /* USBD_HID_KEYBOARD_ONLY */
+
 #ifndef USE_USBD_COMPOSITE
 /* USB Standard Device Descriptor */
 __ALIGN_BEGIN static uint8_t USBD_HID_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_DESC] __ALIGN_END =
@@ -217,7 +346,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_
 };
 #endif /* USE_USBD_COMPOSITE  */
 
-__ALIGN_BEGIN static uint8_t HID_MOUSE_ReportDesc[HID_MOUSE_REPORT_DESC_SIZE] __ALIGN_END =
+__ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SIZE] __ALIGN_END =
 {
   0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
   0x09, 0x06,        // Usage (Keyboard)
@@ -254,6 +383,75 @@ __ALIGN_BEGIN static uint8_t HID_MOUSE_ReportDesc[HID_MOUSE_REPORT_DESC_SIZE] __
 // 63 bytes
 };
 
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+__ALIGN_BEGIN static uint8_t HID_EXTRA_ReportDesc[HID_EXTRA_REPORT_DESC_SIZE] __ALIGN_END =
+{
+  0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+  0x09, 0x06,        // Usage (Keyboard)
+  0xA1, 0x01,        // Collection (Application)
+  0x85, 0x01,        //   Report ID (1): NKRO keyboard
+  0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
+  0x19, 0xE0,        //   Usage Minimum (0xE0)
+  0x29, 0xE7,        //   Usage Maximum (0xE7)
+  0x15, 0x00,        //   Logical Minimum (0)
+  0x25, 0x01,        //   Logical Maximum (1)
+  0x75, 0x01,        //   Report Size (1)
+  0x95, 0x08,        //   Report Count (8)
+  0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+  0x19, 0x00,        //   Usage Minimum (0x00)
+  0x29, 0xDF,        //   Usage Maximum (0xDF)
+  0x95, 0xE0,        //   Report Count (224)
+  0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+  0xC0,              // End Collection
+  0x05, 0x0C,        // Usage Page (Consumer)
+  0x09, 0x01,        // Usage (Consumer Control)
+  0xA1, 0x01,        // Collection (Application)
+  0x85, 0x02,        //   Report ID (2): consumer control
+  0x15, 0x00,        //   Logical Minimum (0)
+  0x26, 0xFF, 0x03,  //   Logical Maximum (1023)
+  0x19, 0x00,        //   Usage Minimum (0x00)
+  0x2A, 0xFF, 0x03,  //   Usage Maximum (0x3FF)
+  0x75, 0x10,        //   Report Size (16)
+  0x95, 0x01,        //   Report Count (1)
+  0x81, 0x00,        //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null Position)
+  0xC0,              // End Collection
+  0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+  0x09, 0x80,        // Usage (Sys Control)
+  0xA1, 0x01,        // Collection (Application)
+  0x85, 0x03,        //   Report ID (3): system control
+  0x15, 0x00,        //   Logical Minimum (0)
+  0x26, 0xB7, 0x00,  //   Logical Maximum (183)
+  0x19, 0x00,        //   Usage Minimum (0x00)
+  0x29, 0xB7,        //   Usage Maximum (0xB7)
+  0x75, 0x10,        //   Report Size (16)
+  0x95, 0x01,        //   Report Count (1)
+  0x81, 0x00,        //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null Position)
+  0xC0,              // End Collection
+// 82 bytes
+};
+
+__ALIGN_BEGIN static uint8_t HID_RAW_ReportDesc[HID_RAW_REPORT_DESC_SIZE] __ALIGN_END =
+{
+  0x06, 0x60, 0xFF,  // Usage Page (Vendor Defined 0xFF60)
+  0x09, 0x61,        // Usage (0x61)
+  0xA1, 0x01,        // Collection (Application)
+  0x09, 0x62,        //   Usage (0x62)
+  0x15, 0x00,        //   Logical Minimum (0)
+  0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+  0x95, 0x40,        //   Report Count (64)
+  0x75, 0x08,        //   Report Size (8)
+  0x81, 0x02,        //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position)
+  0x09, 0x63,        //   Usage (0x63)
+  0x15, 0x00,        //   Logical Minimum (0)
+  0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+  0x95, 0x40,        //   Report Count (64)
+  0x75, 0x08,        //   Report Size (8)
+  0x91, 0x02,        //   Output (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null Position,Non-volatile)
+  0xC0,              // End Collection
+// 34 bytes
+};
+#endif /* USBD_HID_KEYBOARD_ONLY */
+
 static uint8_t HIDInEpAdd = HID_EPIN_ADDR;
 
 /**
@@ -276,6 +474,8 @@ static uint8_t USBD_HID_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
   UNUSED(cfgidx);
 
   USBD_HID_HandleTypeDef *hhid;
+  uint8_t itf;
+  uint8_t epadd;
 
   hhid = (USBD_HID_HandleTypeDef *)USBD_malloc(sizeof(USBD_HID_HandleTypeDef));
 
@@ -293,24 +493,80 @@ static uint8_t USBD_HID_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
   HIDInEpAdd  = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_INTR);
 #endif /* USE_USBD_COMPOSITE */
 
-  if (pdev->dev_speed == USBD_SPEED_HIGH)
-  {
-    pdev->ep_in[HIDInEpAdd & 0xFU].bInterval = HID_HS_BINTERVAL;
-  }
-  else   /* LOW and FULL-speed endpoints */
+  hhid->Protocol = HID_PROTOCOL_REPORT;
+  hhid->LedState = 0U;
+  hhid->CtlRequest = 0U;
+
+  USBD_HID_EpInit(&hhid->Ep[HID_ITF_KEYBOARD], HIDInEpAdd, HID_EPIN_SIZE,
+                  &hhid->KbdQueue[0][0], hhid->KbdLast);
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  USBD_HID_EpInit(&hhid->Ep[HID_ITF_EXTRA], HID_EXT_EPIN_ADDR, HID_EXT_EPIN_SIZE,
+                  &hhid->ExtQueue[0][0], hhid->ExtLast);
+  USBD_HID_EpInit(&hhid->Ep[HID_ITF_RAW], HID_RAW_EPIN_ADDR, HID_RAW_EP_SIZE,
+                  &hhid->RawQueue[0][0], hhid->RawLast);
+#endif /* USBD_HID_KEYBOARD_ONLY */
+
+  /* Open EP IN */
+  for (itf = 0U; itf < HID_ITF_NUM; itf++)
   {
-    pdev->ep_in[HIDInEpAdd & 0xFU].bInterval = HID_FS_BINTERVAL;
+    epadd = hhid->Ep[itf].EpAddr;
+
+    if (pdev->dev_speed == USBD_SPEED_HIGH)
+    {
+      pdev->ep_in[epadd & 0xFU].bInterval = HID_HS_BINTERVAL;
+    }
+    else   /* LOW and FULL-speed endpoints */
+    {
+      pdev->ep_in[epadd & 0xFU].bInterval = HID_FS_BINTERVAL;
+    }
+
+    (void)USBD_LL_OpenEP(pdev, epadd, USBD_EP_TYPE_INTR, hhid->Ep[itf].Size);
+    pdev->ep_in[epadd & 0xFU].is_used = 1U;
   }
 
-  /* Open EP IN */
-  (void)USBD_LL_OpenEP(pdev, HIDInEpAdd, USBD_EP_TYPE_INTR, HID_EPIN_SIZE);
-  pdev->ep_in[HIDInEpAdd & 0xFU].is_used = 1U;
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  /* Open raw HID EP OUT and prepare it to receive the first packet */
+  (void)USBD_LL_OpenEP(pdev, HID_RAW_EPOUT_ADDR, USBD_EP_TYPE_INTR, HID_RAW_EP_SIZE);
+  pdev->ep_out[HID_RAW_EPOUT_ADDR & 0xFU].is_used = 1U;
+  (void)USBD_LL_PrepareReceive(pdev, HID_RAW_EPOUT_ADDR, hhid->RawOut, HID_RAW_EP_SIZE);
+#endif /* USBD_HID_KEYBOARD_ONLY */
 
-  hhid->state = HID_IDLE;
+  /* Open keyboard LED EP OUT */
+  (void)USBD_LL_OpenEP(pdev, HID_EPOUT_ADDR, USBD_EP_TYPE_INTR, HID_EPOUT_SIZE);
+  pdev->ep_out[HID_EPOUT_ADDR & 0xFU].is_used = 1U;
+  (void)USBD_LL_PrepareReceive(pdev, HID_EPOUT_ADDR, hhid->LedOut, HID_EPOUT_SIZE);
 
   return (uint8_t)USBD_OK;
 }
 
+/**
+  * @brief  USBD_HID_EpInit
+  *         Reset the report queue of one IN endpoint
+  * @param  ep: endpoint queue
+  * @param  addr: endpoint address
+  * @param  size: endpoint max packet size
+  * @param  queue: HID_REPORT_QUEUE_SIZE x size bytes of storage
+  * @param  last: size bytes of storage for the last armed report
+  * @retval None
+  */
+static void USBD_HID_EpInit(USBD_HID_EpTypeDef *ep, uint8_t addr, uint8_t size,
+                            uint8_t *queue, uint8_t *last)
+{
+  ep->state = HID_IDLE;
+  ep->Queue = queue;
+  ep->ReportLast = last;
+  ep->QueueHead = 0U;
+  ep->QueueCount = 0U;
+  ep->EpAddr = addr;
+  ep->Size = size;
+  ep->IdleRate = 0U;
+  ep->IdleCount = 0U;
+
+  /* The host starts from an all-released state; the raw interface has no state */
+  (void)USBD_memset(last, 0, size);
+  ep->ReportLastLen = (addr == HID_EPIN_ADDR) ? HID_BOOT_REPORT_SIZE : 0U;
+}
+
 /**
   * @brief  USBD_HID_DeInit
   *         DeInitialize the HID layer
@@ -332,6 +588,22 @@ static uint8_t USBD_HID_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
   pdev->ep_in[HIDInEpAdd & 0xFU].is_used = 0U;
   pdev->ep_in[HIDInEpAdd & 0xFU].bInterval = 0U;
 
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  (void)USBD_LL_CloseEP(pdev, HID_EXT_EPIN_ADDR);
+  pdev->ep_in[HID_EXT_EPIN_ADDR & 0xFU].is_used = 0U;
+  pdev->ep_in[HID_EXT_EPIN_ADDR & 0xFU].bInterval = 0U;
+
+  (void)USBD_LL_CloseEP(pdev, HID_RAW_EPIN_ADDR);
+  pdev->ep_in[HID_RAW_EPIN_ADDR & 0xFU].is_used = 0U;
+  pdev->ep_in[HID_RAW_EPIN_ADDR & 0xFU].bInterval = 0U;
+
+  (void)USBD_LL_CloseEP(pdev, HID_RAW_EPOUT_ADDR);
+  pdev->ep_out[HID_RAW_EPOUT_ADDR & 0xFU].is_used = 0U;
+#endif /* USBD_HID_KEYBOARD_ONLY */
+
+  (void)USBD_LL_CloseEP(pdev, HID_EPOUT_ADDR);
+  pdev->ep_out[HID_EPOUT_ADDR & 0xFU].is_used = 0U;
+
   /* Free allocated memory */
   if (pdev->pClassDataCmsit[pdev->classId] != NULL)
   {
@@ -368,19 +640,76 @@ static uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *re
       switch (req->bRequest)
       {
         case HID_REQ_SET_PROTOCOL:
+          /* Only the keyboard interface has the boot subclass */
+          if (LOBYTE(req->wIndex) != HID_ITF_KEYBOARD)
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+            break;
+          }
+          if (hhid->Protocol != (uint8_t)(req->wValue))
+          {
+            /* The keyboard reports switch interface: drop the ones still
+               queued, and force the first new one out (ReportLast may be in flight) */
+            hhid->Ep[HID_ITF_KEYBOARD].QueueCount = 0U;
+            hhid->Ep[HID_ITF_KEYBOARD].ReportLastLen = 0U;
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+            hhid->Ep[HID_ITF_EXTRA].QueueCount = 0U;
+            hhid->Ep[HID_ITF_EXTRA].ReportLastLen = 0U;
+#endif /* USBD_HID_KEYBOARD_ONLY */
+          }
           hhid->Protocol = (uint8_t)(req->wValue);
           break;
 
         case HID_REQ_GET_PROTOCOL:
-          (void)USBD_CtlSendData(pdev, (uint8_t *)&hhid->Protocol, 1U);
+          if (LOBYTE(req->wIndex) == HID_ITF_KEYBOARD)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&hhid->Protocol, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
           break;
 
         case HID_REQ_SET_IDLE:
-          hhid->IdleState = (uint8_t)(req->wValue >> 8);
+          /* One rate per interface: the report ID in LOBYTE(wValue) is not
+             distinguished, the last report of the interface is repeated */
+          if (LOBYTE(req->wIndex) < HID_ITF_NUM)
+          {
+            hhid->Ep[LOBYTE(req->wIndex)].IdleRate = HIBYTE(req->wValue);
+            hhid->Ep[LOBYTE(req->wIndex)].IdleCount = 0U;
+          }
           break;
 
         case HID_REQ_GET_IDLE:
-          (void)USBD_CtlSendData(pdev, (uint8_t *)&hhid->IdleState, 1U);
+          if (LOBYTE(req->wIndex) < HID_ITF_NUM)
+          {
+            (void)USBD_CtlSendData(pdev, &hhid->Ep[LOBYTE(req->wIndex)].IdleRate, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case HID_REQ_SET_REPORT:
+          /* LED output report through EP0, for hosts not using the OUT endpoint;
+             the data stage completes in USBD_HID_EP0_RxReady */
+          if ((LOBYTE(req->wIndex) == HID_ITF_KEYBOARD) &&
+              (HIBYTE(req->wValue) == HID_REPORT_TYPE_OUTPUT) &&
+              (req->wLength != 0U) && (req->wLength <= HID_EPOUT_SIZE))
+          {
+            hhid->CtlRequest = req->bRequest;
+            (void)USBD_CtlPrepareRx(pdev, hhid->LedCtl, req->wLength);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
           break;
 
         default:
@@ -407,12 +736,40 @@ static uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *re
         case USB_REQ_GET_DESCRIPTOR:
           if ((req->wValue >> 8) == HID_REPORT_DESC)
           {
-            len = MIN(HID_MOUSE_REPORT_DESC_SIZE, req->wLength);
-            pbuf = HID_MOUSE_ReportDesc;
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+            if (LOBYTE(req->wIndex) == HID_ITF_EXTRA)
+            {
+              len = MIN(HID_EXTRA_REPORT_DESC_SIZE, req->wLength);
+              pbuf = HID_EXTRA_ReportDesc;
+            }
+            else if (LOBYTE(req->wIndex) == HID_ITF_RAW)
+            {
+              len = MIN(HID_RAW_REPORT_DESC_SIZE, req->wLength);
+              pbuf = HID_RAW_ReportDesc;
+            }
+            else
+#endif /* USBD_HID_KEYBOARD_ONLY */
+            {
+              len = MIN(HID_KEYBOARD_REPORT_DESC_SIZE, req->wLength);
+              pbuf = HID_KEYBOARD_ReportDesc;
+            }
           }
           else if ((req->wValue >> 8) == HID_DESCRIPTOR_TYPE)
           {
-            pbuf = USBD_HID_Desc;
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+            if (LOBYTE(req->wIndex) == HID_ITF_EXTRA)
+            {
+              pbuf = USBD_HID_ExtDesc;
+            }
+            else if (LOBYTE(req->wIndex) == HID_ITF_RAW)
+            {
+              pbuf = USBD_HID_RawDesc;
+            }
+            else
+#endif /* USBD_HID_KEYBOARD_ONLY */
+            {
+              pbuf = USBD_HID_Desc;
+            }
             len = MIN(USB_HID_DESC_SIZ, req->wLength);
           }
           else
@@ -469,35 +826,336 @@ static uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *re
 
 /**
   * @brief  USBD_HID_SendReport
-  *         Send HID Report
+  *         Queue a boot keyboard HID Report on interface 0
   * @param  pdev: device instance
   * @param  buff: pointer to report
-  * @retval status
+  * @retval status: USBD_BUSY when the queue is full
   */
 uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *report, uint16_t len)
+{
+  return USBD_HID_SendReportItf(pdev, HID_ITF_KEYBOARD, report, len);
+}
+
+/**
+  * @brief  USBD_HID_SendReportItf
+  *         Queue a HID Report on the IN endpoint of an interface; queued
+  *         reports are armed one per host poll (SOF/DataIn), so none is
+  *         dropped while busy. Every interface has its own endpoint and
+  *         queue, so a burst on one never delays the others.
+  *         On the keyboard interfaces a report equal to the last queued one
+  *         is discarded, and the last queued report is replaced when no key
+  *         transition would be lost. Raw HID reports are always queued.
+  * @param  pdev: device instance
+  * @param  itf: HID_ITF_KEYBOARD, HID_ITF_EXTRA or HID_ITF_RAW
+  * @param  report: pointer to report (starting with the report ID on HID_ITF_EXTRA)
+  * @param  len: report length, at most the endpoint size
+  * @retval status: USBD_BUSY when the queue is full
+  */
+uint8_t USBD_HID_SendReportItf(USBD_HandleTypeDef *pdev, uint8_t itf, uint8_t *report, uint16_t len)
 {
   USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+  USBD_HID_EpTypeDef *ep;
+  USBD_StatusTypeDef ret = USBD_OK;
+  uint8_t *tail_buf;
+  uint8_t *prev;
+  uint8_t prev_len;
+  uint32_t tail;
+  uint32_t primask;
 
-  if (hhid == NULL)
+  if ((hhid == NULL) || (itf >= HID_ITF_NUM) || (len > hhid->Ep[itf].Size))
   {
     return (uint8_t)USBD_FAIL;
   }
 
-#ifdef USE_USBD_COMPOSITE
-  /* Get the Endpoints addresses allocated for this class instance */
-  HIDInEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_INTR);
-#endif /* USE_USBD_COMPOSITE */
+  /* While suspended the report stays queued and goes out after resume,
+     so the key press that woke the host is not lost */
+  if ((pdev->dev_state != USBD_STATE_CONFIGURED) &&
+      ((pdev->dev_state != USBD_STATE_SUSPENDED) || (pdev->dev_old_state != USBD_STATE_CONFIGURED)))
+  {
+    return (uint8_t)USBD_OK;
+  }
+
+  ep = &hhid->Ep[itf];
+
+  /* SOF/DataIn pop the queue head: update the queue atomically */
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  tail = (ep->QueueHead + ep->QueueCount - 1U) & (HID_REPORT_QUEUE_SIZE - 1U);
+  tail_buf = &ep->Queue[tail * ep->Size];
 
-  if (pdev->dev_state == USBD_STATE_CONFIGURED)
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  if (itf == HID_ITF_RAW)
   {
-    if (hhid->state == HID_IDLE)
+    /* Raw HID packets are messages, not states: never drop or merge them */
+  }
+  else
+#endif /* USBD_HID_KEYBOARD_ONLY */
+  if (ep->QueueCount == 0U)
+  {
+    /* Nothing queued: only compare with the report the host has or is about to get */
+    if ((ep->ReportLastLen == len) && (memcmp(ep->ReportLast, report, len) == 0))
     {
-      hhid->state = HID_BUSY;
-      (void)USBD_LL_Transmit(pdev, HIDInEpAdd, report, len);
+      __set_PRIMASK(primask);
+      return (uint8_t)USBD_OK;
     }
   }
+  else
+  {
+    if (ep->QueueCount > 1U)
+    {
+      prev = &ep->Queue[((tail - 1U) & (HID_REPORT_QUEUE_SIZE - 1U)) * ep->Size];
+      prev_len = ep->QueueLen[(tail - 1U) & (HID_REPORT_QUEUE_SIZE - 1U)];
+    }
+    else
+    {
+      prev = ep->ReportLast;
+      prev_len = ep->ReportLastLen;
+    }
 
-  return (uint8_t)USBD_OK;
+    if ((ep->QueueLen[tail] == len) &&
+        ((memcmp(tail_buf, report, len) == 0) ||
+         ((prev_len == len) && (USBD_HID_ReportsMergeable(itf, prev, tail_buf, report, len) != 0U))))
+    {
+      (void)USBD_memcpy(tail_buf, report, len);
+      __set_PRIMASK(primask);
+      return (uint8_t)USBD_OK;
+    }
+  }
+
+  if (ep->QueueCount < HID_REPORT_QUEUE_SIZE)
+  {
+    tail = (tail + 1U) & (HID_REPORT_QUEUE_SIZE - 1U);
+    (void)USBD_memcpy(&ep->Queue[tail * ep->Size], report, len);
+    ep->QueueLen[tail] = (uint8_t)len;
+    ep->QueueCount++;
+  }
+  else
+  {
+    ret = USBD_BUSY;
+  }
+
+  __set_PRIMASK(primask);
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_HID_ReportsMergeable
+  *         Check whether report 'tail' can be replaced by 'next' without
+  *         hiding a transition: no modifier bit or key may change from
+  *         'prev' to 'tail' and change back from 'tail' to 'next'.
+  *         Boot reports carry a key array, NKRO reports a bitmap; consumer
+  *         and system control reports hold a single usage and never merge.
+  * @param  itf: interface of the reports
+  * @param  prev: report preceding tail
+  * @param  tail: last queued report
+  * @param  next: new report
+  * @param  len: length of all three reports
+  * @retval 1 if mergeable, 0 otherwise
+  */
+static uint8_t USBD_HID_ReportsMergeable(uint8_t itf, const uint8_t *prev, const uint8_t *tail,
+                                         const uint8_t *next, uint16_t len)
+{
+  uint16_t i;
+
+#if (USBD_HID_KEYBOARD_ONLY == 1U)
+  UNUSED(itf);
+#else
+  if (itf == HID_ITF_EXTRA)
+  {
+    if ((prev[0] != HID_REPORT_ID_NKRO) || (tail[0] != HID_REPORT_ID_NKRO) ||
+        (next[0] != HID_REPORT_ID_NKRO))
+    {
+      return 0U;
+    }
+
+    /* Modifier byte and usage bitmap: plain bitwise check */
+    for (i = 1U; i < len; i++)
+    {
+      if (((prev[i] ^ tail[i]) & (tail[i] ^ next[i])) != 0U)
+      {
+        return 0U;
+      }
+    }
+
+    return 1U;
+  }
+#endif /* USBD_HID_KEYBOARD_ONLY */
+
+  /* Byte 0: modifier bitmap */
+  if (((prev[0] ^ tail[0]) & (tail[0] ^ next[0])) != 0U)
+  {
+    return 0U;
+  }
+
+  /* Bytes 2..len-1: key array, order is not significant */
+  for (i = 2U; i < len; i++)
+  {
+    /* Key pressed only in tail */
+    if ((tail[i] != 0U) && (USBD_HID_ReportHasKey(prev, len, tail[i]) == 0U) &&
+        (USBD_HID_ReportHasKey(next, len, tail[i]) == 0U))
+    {
+      return 0U;
+    }
+
+    /* Key released only in tail */
+    if ((prev[i] != 0U) && (USBD_HID_ReportHasKey(tail, len, prev[i]) == 0U) &&
+        (USBD_HID_ReportHasKey(next, len, prev[i]) != 0U))
+    {
+      return 0U;
+    }
+  }
+
+  return 1U;
+}
+
+/**
+  * @brief  USBD_HID_ReportHasKey
+  *         Search the key array of a boot keyboard report
+  * @param  report: pointer to report
+  * @param  len: report length
+  * @param  key: usage code
+  * @retval 1 if present, 0 otherwise
+  */
+static uint8_t USBD_HID_ReportHasKey(const uint8_t *report, uint16_t len, uint8_t key)
+{
+  uint16_t i;
+
+  for (i = 2U; i < len; i++)
+  {
+    if (report[i] == key)
+    {
+      return 1U;
+    }
+  }
+
+  return 0U;
+}
+
+/**
+  * @brief  USBD_HID_ArmNext
+  *         Arm the queue head on its IN endpoint if the endpoint is free
+  *         (called from the USB interrupt)
+  * @param  pdev: device instance
+  * @param  ep: endpoint queue
+  * @retval None
+  */
+static void USBD_HID_ArmNext(USBD_HandleTypeDef *pdev, USBD_HID_EpTypeDef *ep)
+{
+  if ((ep->state != HID_IDLE) || (ep->QueueCount == 0U))
+  {
+    return;
+  }
+
+  /* ReportLast stays untouched until DataIn, so it doubles as transmit buffer */
+  ep->ReportLastLen = ep->QueueLen[ep->QueueHead];
+  (void)USBD_memcpy(ep->ReportLast, &ep->Queue[ep->QueueHead * ep->Size], ep->ReportLastLen);
+  ep->QueueHead = (uint8_t)((ep->QueueHead + 1U) & (HID_REPORT_QUEUE_SIZE - 1U));
+  ep->QueueCount--;
+
+  ep->state = HID_BUSY;
+  ep->IdleCount = 0U;
+  (void)USBD_LL_Transmit(pdev, ep->EpAddr, ep->ReportLast, ep->ReportLastLen);
+}
+
+/**
+  * @brief  USBD_HID_RawReceived
+  *         Called from the USB interrupt for each packet received on the
+  *         raw HID OUT endpoint; override to handle vendor commands
+  * @param  pdev: device instance
+  * @param  buf: received data, valid until this function returns
+  * @param  len: number of bytes received
+  * @retval None
+  */
+__weak void USBD_HID_RawReceived(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t len)
+{
+  UNUSED(pdev);
+  UNUSED(buf);
+  UNUSED(len);
+}
+
+/**
+  * @brief  USBD_HID_ReportSent
+  *         Called from the USB interrupt each time the host has read a
+  *         report from an IN endpoint, i.e. once per consumed poll slot;
+  *         override to pace report generation to the host polling rate
+  * @param  pdev: device instance
+  * @param  itf: interface whose report was sent
+  * @retval None
+  */
+__weak void USBD_HID_ReportSent(USBD_HandleTypeDef *pdev, uint8_t itf)
+{
+  UNUSED(pdev);
+  UNUSED(itf);
+}
+
+/**
+  * @brief  USBD_HID_SetLedState
+  *         record the lock state received from the host and report changes
+  * @param  pdev: device instance
+  * @param  hhid: class handle
+  * @param  leds: LED output report (HID_LED_xxx bits)
+  * @retval None
+  */
+static void USBD_HID_SetLedState(USBD_HandleTypeDef *pdev, USBD_HID_HandleTypeDef *hhid, uint8_t leds)
+{
+  if (hhid->LedState != leds)
+  {
+    hhid->LedState = leds;
+    USBD_HID_LedStateChanged(pdev, leds);
+  }
+}
+
+/**
+  * @brief  USBD_HID_LedStateChanged
+  *         Called from the USB interrupt when the host changes the lock
+  *         state, through either the OUT endpoint or SET_REPORT
+  * @param  pdev: device instance
+  * @param  leds: new LED output report (HID_LED_xxx bits)
+  * @retval None
+  */
+__weak void USBD_HID_LedStateChanged(USBD_HandleTypeDef *pdev, uint8_t leds)
+{
+  UNUSED(pdev);
+  UNUSED(leds);
+}
+
+/**
+  * @brief  USBD_HID_GetLedState
+  *         return the lock state last set by the host (HID_LED_xxx bits)
+  * @param  pdev: device instance
+  * @retval LED output report
+  */
+uint8_t USBD_HID_GetLedState(USBD_HandleTypeDef *pdev)
+{
+  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hhid == NULL)
+  {
+    return 0U;
+  }
+
+  return hhid->LedState;
+}
+
+/**
+  * @brief  USBD_HID_GetProtocol
+  *         return the protocol selected by SET_PROTOCOL, which decides
+  *         the report layout (boot: 8-byte key array, report: NKRO bitmap)
+  * @param  pdev: device instance
+  * @retval HID_PROTOCOL_BOOT or HID_PROTOCOL_REPORT
+  */
+uint8_t USBD_HID_GetProtocol(USBD_HandleTypeDef *pdev)
+{
+  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hhid == NULL)
+  {
+    return (uint8_t)HID_PROTOCOL_REPORT;
+  }
+
+  return (uint8_t)hhid->Protocol;
 }
 
 /**
@@ -538,12 +1196,7 @@ uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev)
   */
 static uint8_t *USBD_HID_GetFSCfgDesc(uint16_t *length)
 {
-  USBD_EpDescTypeDef *pEpDesc = USBD_GetEpDesc(USBD_HID_CfgDesc, HID_EPIN_ADDR);
-
-  if (pEpDesc != NULL)
-  {
-    pEpDesc->bInterval = HID_FS_BINTERVAL;
-  }
+  USBD_HID_SetCfgDescInterval(HID_FS_BINTERVAL);
 
   *length = (uint16_t)sizeof(USBD_HID_CfgDesc);
   return USBD_HID_CfgDesc;
@@ -558,12 +1211,7 @@ static uint8_t *USBD_HID_GetFSCfgDesc(uint16_t *length)
   */
 static uint8_t *USBD_HID_GetHSCfgDesc(uint16_t *length)
 {
-  USBD_EpDescTypeDef *pEpDesc = USBD_GetEpDesc(USBD_HID_CfgDesc, HID_EPIN_ADDR);
-
-  if (pEpDesc != NULL)
-  {
-    pEpDesc->bInterval = HID_HS_BINTERVAL;
-  }
+  USBD_HID_SetCfgDescInterval(HID_HS_BINTERVAL);
 
   *length = (uint16_t)sizeof(USBD_HID_CfgDesc);
   return USBD_HID_CfgDesc;
@@ -578,16 +1226,39 @@ static uint8_t *USBD_HID_GetHSCfgDesc(uint16_t *length)
   */
 static uint8_t *USBD_HID_GetOtherSpeedCfgDesc(uint16_t *length)
 {
-  USBD_EpDescTypeDef *pEpDesc = USBD_GetEpDesc(USBD_HID_CfgDesc, HID_EPIN_ADDR);
-
-  if (pEpDesc != NULL)
-  {
-    pEpDesc->bInterval = HID_FS_BINTERVAL;
-  }
+  USBD_HID_SetCfgDescInterval(HID_FS_BINTERVAL);
 
   *length = (uint16_t)sizeof(USBD_HID_CfgDesc);
   return USBD_HID_CfgDesc;
 }
+
+/**
+  * @brief  USBD_HID_SetCfgDescInterval
+  *         set bInterval of every endpoint in the configuration descriptor
+  * @param  bInterval: polling interval
+  * @retval None
+  */
+static void USBD_HID_SetCfgDescInterval(uint8_t bInterval)
+{
+#if (USBD_HID_KEYBOARD_ONLY == 1U)
+  static const uint8_t ep_addr[] = {HID_EPIN_ADDR, HID_EPOUT_ADDR};
+#else
+  static const uint8_t ep_addr[] = {HID_EPIN_ADDR, HID_EPOUT_ADDR, HID_EXT_EPIN_ADDR,
+                                    HID_RAW_EPIN_ADDR, HID_RAW_EPOUT_ADDR};
+#endif /* USBD_HID_KEYBOARD_ONLY */
+  USBD_EpDescTypeDef *pEpDesc;
+  uint32_t i;
+
+  for (i = 0U; i < sizeof(ep_addr); i++)
+  {
+    pEpDesc = USBD_GetEpDesc(USBD_HID_CfgDesc, ep_addr[i]);
+
+    if (pEpDesc != NULL)
+    {
+      pEpDesc->bInterval = bInterval;
+    }
+  }
+}
 #endif /* USE_USBD_COMPOSITE  */
 
 /**
@@ -599,10 +1270,141 @@ static uint8_t *USBD_HID_GetOtherSpeedCfgDesc(uint16_t *length)
   */
 static uint8_t USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
 {
-  UNUSED(epnum);
-  /* Ensure that the FIFO is empty before a new transfer, this condition could
-  be caused by  a new transfer before the end of the previous transfer */
-  ((USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId])->state = HID_IDLE;
+  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+  uint8_t itf;
+
+  if (hhid == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  for (itf = 0U; itf < HID_ITF_NUM; itf++)
+  {
+    if ((hhid->Ep[itf].EpAddr & 0x7FU) == epnum)
+    {
+      /* Ensure that the FIFO is empty before a new transfer, this condition could
+      be caused by  a new transfer before the end of the previous transfer */
+      hhid->Ep[itf].state = HID_IDLE;
+
+      USBD_HID_ReportSent(pdev, itf);
+
+      /* Have the next queued report ready for the following host poll */
+      USBD_HID_ArmNext(pdev, &hhid->Ep[itf]);
+    }
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_DataOut
+  *         handle data OUT Stage: keyboard LED and raw HID packets
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_HID_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hhid == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if (epnum == (HID_EPOUT_ADDR & 0x7FU))
+  {
+    if (USBD_LL_GetRxDataSize(pdev, epnum) != 0U)
+    {
+      USBD_HID_SetLedState(pdev, hhid, hhid->LedOut[0]);
+    }
+
+    (void)USBD_LL_PrepareReceive(pdev, HID_EPOUT_ADDR, hhid->LedOut, HID_EPOUT_SIZE);
+  }
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+  else if (epnum == (HID_RAW_EPOUT_ADDR & 0x7FU))
+  {
+    USBD_HID_RawReceived(pdev, hhid->RawOut, (uint16_t)USBD_LL_GetRxDataSize(pdev, epnum));
+
+    /* Prepare Out endpoint to receive next packet */
+    (void)USBD_LL_PrepareReceive(pdev, HID_RAW_EPOUT_ADDR, hhid->RawOut, HID_RAW_EP_SIZE);
+  }
+#endif /* USBD_HID_KEYBOARD_ONLY */
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_EP0_RxReady
+  *         handle the data stage of SET_REPORT (Output)
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hhid == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if (hhid->CtlRequest == HID_REQ_SET_REPORT)
+  {
+    USBD_HID_SetLedState(pdev, hhid, hhid->LedCtl[0]);
+  }
+  hhid->CtlRequest = 0U;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_SOF
+  *         handle SOF event: arm the next queued report on each free IN endpoint,
+  *         and repeat the last report when the SET_IDLE period has elapsed
+  *         without any report being sent
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_HID_SOF(USBD_HandleTypeDef *pdev)
+{
+  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+  USBD_HID_EpTypeDef *ep;
+  uint16_t idle_sofs;
+  uint8_t itf;
+
+  if (hhid == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  for (itf = 0U; itf < HID_ITF_NUM; itf++)
+  {
+    ep = &hhid->Ep[itf];
+    USBD_HID_ArmNext(pdev, ep);
+
+    /* The raw interface carries no state worth repeating */
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+    if (itf == HID_ITF_RAW)
+    {
+      continue;
+    }
+#endif /* USBD_HID_KEYBOARD_ONLY */
+    if ((ep->IdleRate == 0U) || (ep->state != HID_IDLE))
+    {
+      continue;
+    }
+
+    /* Idle rate unit is 4 ms: 4 frames, or 32 microframes at high speed */
+    idle_sofs = (uint16_t)ep->IdleRate * ((pdev->dev_speed == USBD_SPEED_HIGH) ? 32U : 4U);
+
+    if ((++ep->IdleCount >= idle_sofs) && (ep->ReportLastLen != 0U))
+    {
+      ep->state = HID_BUSY;
+      ep->IdleCount = 0U;
+      (void)USBD_LL_Transmit(pdev, ep->EpAddr, ep->ReportLast, ep->ReportLastLen);
+    }
+  }
 
   return (uint8_t)USBD_OK;
 }
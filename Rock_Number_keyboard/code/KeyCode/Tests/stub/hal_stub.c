@@ -0,0 +1,99 @@
+// 主机测试用的 HAL 函数替身：时间由测试程序通过 stub_tick_ms / stub_micros 推进，
+// PWM DMA 的启动参数记录在 stub_pwm_* 中供检查。
+#include "hal_stub.h"
+#include "tim.h"
+#include "timebase.h"
+
+SCB_Type stub_scb;
+EXTI_TypeDef stub_exti;
+GPIO_TypeDef stub_gpioa, stub_gpiob, stub_gpioe;
+TIM_TypeDef stub_tim1, stub_tim3, stub_tim4;
+uint32_t SystemCoreClock = 168000000U;
+
+TIM_HandleTypeDef htim3 = { &stub_tim3 };
+TIM_HandleTypeDef htim4 = { &stub_tim4 };
+DMA_HandleTypeDef hdma_tim4_ch1;
+
+uint32_t stub_tick_ms = 0;
+uint64_t stub_micros = 0;
+uint64_t stub_cycles = 0;
+const uint32_t *stub_pwm_data = NULL;
+uint16_t stub_pwm_length = 0;
+bool stub_pwm_running = false;
+
+void Error_Handler(void)
+{
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init)
+{
+    (void)port;
+    (void)init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    port->BSRR = (state == GPIO_PIN_SET) ? pin : ((uint32_t)pin << 16);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub)
+{
+    (void)irqn;
+    (void)preempt;
+    (void)sub;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irqn)
+{
+    (void)irqn;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return stub_tick_ms;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t *data, uint16_t length)
+{
+    (void)htim;
+    (void)channel;
+    stub_pwm_data = data;
+    stub_pwm_length = length;
+    stub_pwm_running = true;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t channel)
+{
+    (void)htim;
+    (void)channel;
+    stub_pwm_running = false;
+    return HAL_OK;
+}
+
+__weak void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+}
+
+uint64_t Timebase_Cycles(void)
+{
+    return stub_cycles;
+}
+
+uint64_t Timebase_Micros(void)
+{
+    return stub_micros;
+}
@@ -0,0 +1,14 @@
+#ifndef __HAL_STUB_H
+#define __HAL_STUB_H
+
+#include "stm32f4xx_hal.h"
+
+// 测试程序控制的时间与观测到的PWM DMA启动参数（见 hal_stub.c）
+extern uint32_t stub_tick_ms;
+extern uint64_t stub_micros;
+extern uint64_t stub_cycles;
+extern const uint32_t *stub_pwm_data;
+extern uint16_t stub_pwm_length;
+extern bool stub_pwm_running;
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+// 主机测试用的 HAL/CMSIS 替身：只提供被测模块用到的类型、外设寄存器与函数，
+// 外设是普通内存对象，中断屏蔽为空操作，内存屏障只阻止编译器重排。固件构建不使用本目录。
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define __weak __attribute__((weak))
+
+typedef enum { HAL_OK = 0, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+
+// ---- CMSIS 内核函数 ----
+static inline void __DMB(void) { __atomic_signal_fence(__ATOMIC_SEQ_CST); }  // 测试为单线程，只需编译器屏障
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) {}
+static inline uint32_t __CLZ(uint32_t x) { return x ? (uint32_t)__builtin_clz(x) : 32U; }
+static inline uint32_t __RBIT(uint32_t x)
+{
+    x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+    x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+    x = ((x >> 4) & 0x0F0F0F0FU) | ((x & 0x0F0F0F0FU) << 4);
+    return __builtin_bswap32(x);
+}
+
+typedef enum {
+    PendSV_IRQn = -2,
+    EXTI0_IRQn = 6, EXTI1_IRQn = 7, EXTI2_IRQn = 8, EXTI3_IRQn = 9, EXTI4_IRQn = 10,
+    EXTI9_5_IRQn = 23, EXTI15_10_IRQn = 40,
+} IRQn_Type;
+
+typedef struct { volatile uint32_t ICSR; } SCB_Type;
+typedef struct { volatile uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR; } EXTI_TypeDef;
+typedef struct { volatile uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2]; } GPIO_TypeDef;
+typedef struct { volatile uint32_t CNT, ARR; } TIM_TypeDef;
+
+extern SCB_Type stub_scb;
+extern EXTI_TypeDef stub_exti;
+extern GPIO_TypeDef stub_gpioa, stub_gpiob, stub_gpioe;
+extern TIM_TypeDef stub_tim1, stub_tim3, stub_tim4;
+
+#define SCB   (&stub_scb)
+#define EXTI  (&stub_exti)
+#define GPIOA (&stub_gpioa)
+#define GPIOB (&stub_gpiob)
+#define GPIOE (&stub_gpioe)
+#define TIM1  (&stub_tim1)
+#define TIM3  (&stub_tim3)
+#define TIM4  (&stub_tim4)
+#define SCB_ICSR_PENDSVSET_Msk (1UL << 28)
+
+extern uint32_t SystemCoreClock;
+
+// ---- GPIO ----
+#define GPIO_PIN_0  0x0001U
+#define GPIO_PIN_1  0x0002U
+#define GPIO_PIN_2  0x0004U
+#define GPIO_PIN_3  0x0008U
+#define GPIO_PIN_4  0x0010U
+#define GPIO_PIN_5  0x0020U
+#define GPIO_PIN_6  0x0040U
+#define GPIO_PIN_7  0x0080U
+#define GPIO_PIN_8  0x0100U
+#define GPIO_PIN_9  0x0200U
+#define GPIO_PIN_10 0x0400U
+#define GPIO_PIN_11 0x0800U
+#define GPIO_PIN_12 0x1000U
+#define GPIO_PIN_13 0x2000U
+#define GPIO_PIN_14 0x4000U
+#define GPIO_PIN_15 0x8000U
+
+#define GPIO_MODE_INPUT       0U
+#define GPIO_MODE_OUTPUT_PP   1U
+#define GPIO_MODE_IT_RISING   2U
+#define GPIO_NOPULL           0U
+#define GPIO_PULLDOWN         2U
+#define GPIO_SPEED_FREQ_HIGH  2U
+
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_GPIOE_CLK_ENABLE() ((void)0)
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub);
+void HAL_NVIC_EnableIRQ(IRQn_Type irqn);
+uint32_t HAL_GetTick(void);
+
+// ---- TIM / DMA ----
+typedef struct __DMA_HandleTypeDef {
+    void *Instance;
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+} DMA_HandleTypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+#define TIM_CHANNEL_1 0x0000U
+
+#define __HAL_TIM_SET_COUNTER(h, v)    ((h)->Instance->CNT = (v))
+#define __HAL_TIM_GET_COUNTER(h)       ((h)->Instance->CNT)
+#define __HAL_TIM_SET_AUTORELOAD(h, v) ((h)->Instance->ARR = (v))
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t *data, uint16_t length);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t channel);
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim);
+
+#endif
@@ -0,0 +1,298 @@
+// 矩阵消抖主机测试：同一组原始电平序列分别送入改造前的逐键积分状态机（参考模型）
+// 与 matrix_keyboard.c 的纵向计数器下半部，要求每个按键的事件序列（按下/长按/连发/释放及其时刻）完全一致，
+// 并比较每次采样的耗时。
+// 默认编译为板上的5x4矩阵；Makefile 另以 -DROW_NUM=6 -DCOL_NUM=17 编译一份，由本文件提供引脚与按键映射，
+// 覆盖一行跨两个32位字的矩阵位图。
+// 直接包含被测源文件，以便绕过GPIO扫描直接处理快照。
+#ifdef ROW_NUM
+#include "hal_stub.h"
+
+#define MATRIX_EXTERNAL_LAYOUT
+static GPIO_TypeDef* ROW_Port[ROW_NUM];
+static uint16_t ROW_Pin[ROW_NUM];
+static GPIO_TypeDef* COL_Port[COL_NUM];
+static uint16_t COL_Pin[COL_NUM];
+static uint8_t Key_Map[ROW_NUM][COL_NUM];
+
+// 行在 GPIOE，前16列在 GPIOA、其余在 GPIOB；每7个位置空一个（无效按键）
+static void make_layout(void)
+{
+    for (int r = 0; r < ROW_NUM; r++) {
+        ROW_Port[r] = GPIOE;
+        ROW_Pin[r] = (uint16_t)(1U << (r % 16));
+    }
+    for (int c = 0; c < COL_NUM; c++) {
+        COL_Port[c] = (c < 16) ? GPIOA : GPIOB;
+        COL_Pin[c] = (uint16_t)(1U << (c % 16));
+    }
+    for (int k = 0; k < ROW_NUM * COL_NUM; k++) {
+        Key_Map[k / COL_NUM][k % COL_NUM] = (k % 7 == 3) ? 0x00 : (uint8_t)(0x04 + k);
+    }
+}
+#endif
+
+#include "../Core/Src/matrix_keyboard.c"
+#include "hal_stub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TRACE_MS 200000
+
+static int s_fails = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); s_fails++; } \
+} while (0)
+
+// ---- 参考模型：改造前的逐键积分消抖 + 状态机（只处理原始位变化或计时中的按键） ----
+typedef enum { REF_IDLE, REF_DEBOUNCE, REF_PRESSED, REF_LONG_PRESS } RefState;
+
+static struct {
+    RefState state;
+    uint32_t timer;
+} s_ref_fsm[ROW_NUM][COL_NUM];
+static uint8_t s_ref_int[ROW_NUM][COL_NUM];
+static MatrixRowBits s_ref_raw[ROW_NUM];
+static MatrixRowBits s_ref_busy[ROW_NUM];
+static uint32_t s_ref_events[MATRIX_KEY_NUM][4];
+static uint32_t s_new_events[MATRIX_KEY_NUM][4];
+
+// 每个按键的事件序列：类型与所在的1ms采样
+#define KEY_LOG_MAX 1024
+
+typedef struct {
+    uint32_t n;
+    uint32_t ms[KEY_LOG_MAX];
+    uint8_t type[KEY_LOG_MAX];
+} KeyLog;
+
+static KeyLog s_ref_log[MATRIX_KEY_NUM];
+static KeyLog s_new_log[MATRIX_KEY_NUM];
+
+static inline void log_event(KeyLog *log, KeyEventType type, uint32_t ms)
+{
+    if (log->n < KEY_LOG_MAX) {
+        log->ms[log->n] = ms;
+        log->type[log->n] = (uint8_t)type;
+    }
+    log->n++;
+}
+
+static inline void ref_event(uint8_t r, uint8_t c, KeyEventType type, uint32_t now)
+{
+    s_ref_events[r * COL_NUM + c][type]++;
+    log_event(&s_ref_log[r * COL_NUM + c], type, now);
+}
+
+static inline void ref_key_step(uint8_t r, uint8_t c, uint8_t is_pressed, uint32_t now)
+{
+    switch (s_ref_fsm[r][c].state) {
+        case REF_IDLE:
+            if (is_pressed) {
+                s_ref_fsm[r][c].state = REF_DEBOUNCE;
+                s_ref_int[r][c] = 0;
+                s_ref_fsm[r][c].timer = now;
+            }
+            break;
+        case REF_DEBOUNCE:
+            if (is_pressed) {
+                if (s_ref_int[r][c] < 255) s_ref_int[r][c]++;
+                if (s_ref_int[r][c] >= INT_PRESS_THRESH) {
+                    s_ref_fsm[r][c].state = REF_PRESSED;
+                    s_ref_fsm[r][c].timer = now;
+                    ref_event(r, c, KEY_EVENT_PRESS, now);
+                }
+            } else {
+                if (s_ref_int[r][c] > 0) s_ref_int[r][c]--;
+                if (s_ref_int[r][c] == 0) s_ref_fsm[r][c].state = REF_IDLE;
+            }
+            break;
+        case REF_PRESSED:
+        case REF_LONG_PRESS:
+            if (is_pressed) {
+                bool is_long = s_ref_fsm[r][c].state == REF_LONG_PRESS;
+                if (now - s_ref_fsm[r][c].timer >= (is_long ? KEY_REPEAT_INTERVAL : KEY_LONG_PRESS_TIME)) {
+                    s_ref_fsm[r][c].state = REF_LONG_PRESS;
+                    s_ref_fsm[r][c].timer = now;
+                    ref_event(r, c, is_long ? KEY_EVENT_REPEAT : KEY_EVENT_LONG_PRESS, now);
+                }
+            } else {
+                if (s_ref_int[r][c] > 0) s_ref_int[r][c]--;
+                if (s_ref_int[r][c] <= INT_RELEASE_THRESH) {
+                    s_ref_fsm[r][c].state = REF_IDLE;
+                    ref_event(r, c, KEY_EVENT_RELEASE, now);
+                }
+            }
+            break;
+    }
+
+    if (s_ref_fsm[r][c].state == REF_IDLE) {
+        s_ref_busy[r] &= ~(1UL << c);
+    } else {
+        s_ref_busy[r] |= (1UL << c);
+    }
+}
+
+static void ref_scan(const MatrixRowBits *rows, uint32_t now)
+{
+    for (uint8_t r = 0; r < ROW_NUM; r++) {
+        MatrixRowBits raw = rows[r] & s_valid_bits[r];
+        MatrixRowBits work = (raw ^ s_ref_raw[r]) | s_ref_busy[r];
+        s_ref_raw[r] = raw;
+
+        while (work != 0U) {
+            uint8_t c = (uint8_t)__builtin_ctz(work);
+            work &= work - 1U;
+            ref_key_step(r, c, (uint8_t)((raw >> c) & 1U), now);
+        }
+    }
+}
+
+static void new_drain(void)
+{
+    KeyEvent events[MATRIX_EVENT_QUEUE_SIZE];
+    uint8_t n = MatrixKeyboard_PopEvents(events, MATRIX_EVENT_QUEUE_SIZE);
+
+    for (uint8_t i = 0; i < n; i++) {
+        int k = events[i].row * COL_NUM + events[i].col;
+
+        s_new_events[k][events[i].event]++;
+        log_event(&s_new_log[k], events[i].event, (uint32_t)(events[i].timestamp_us / 1000U));
+    }
+}
+
+// 干净的随机按键序列：按住 30~1230ms、松开 100~3100ms，空闲键偶尔出现单次采样的毛刺
+static MatrixRowBits s_trace[TRACE_MS][ROW_NUM];
+
+static void make_trace(void)
+{
+    bool held[MATRIX_KEY_NUM] = {false};
+    int left[MATRIX_KEY_NUM] = {0};
+
+    srand(1);
+    for (int t = 0; t < TRACE_MS; t++) {
+        for (int k = 0; k < MATRIX_KEY_NUM; k++) {
+            bool level;
+
+            if (left[k] > 0) {
+                left[k]--;
+            } else if (rand() % 1000 < 3) {
+                held[k] = !held[k];
+                left[k] = held[k] ? 30 + rand() % 1200 : 100 + rand() % 3000;
+            }
+            level = held[k] || (left[k] > 10 && rand() % 500 == 0);
+            if (level) s_trace[t][k / COL_NUM] |= 1UL << (k % COL_NUM);
+        }
+    }
+}
+
+// ---- 被测实现：下半部处理一个1ms快照（与参考模型一样从行位图开始，不含上半部的快照环） ----
+static RawSnapshot s_snaps[TRACE_MS];
+
+static void make_snapshots(void)
+{
+    for (int t = 0; t < TRACE_MS; t++) {
+        for (uint8_t r = 0; r < ROW_NUM; r++) {
+            put_row_bits(s_snaps[t].any, r, s_trace[t][r] & s_valid_bits[r]);
+        }
+        memcpy(s_snaps[t].all, s_snaps[t].any, sizeof(s_snaps[t].all));
+        s_snaps[t].tick_ms = (uint32_t)t + 1U;
+        s_snaps[t].time_us = ((uint64_t)t + 1U) * 1000U;
+    }
+}
+
+static double elapsed_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+static void ref_reset(void)
+{
+    memset(s_ref_fsm, 0, sizeof(s_ref_fsm));
+    memset(s_ref_int, 0, sizeof(s_ref_int));
+    memset(s_ref_raw, 0, sizeof(s_ref_raw));
+    memset(s_ref_busy, 0, sizeof(s_ref_busy));
+    memset(s_ref_events, 0, sizeof(s_ref_events));
+    memset(s_ref_log, 0, sizeof(s_ref_log));
+}
+
+static void new_reset(void)
+{
+    MatrixKeyboard_Init();
+    memset(s_new_events, 0, sizeof(s_new_events));
+    memset(s_new_log, 0, sizeof(s_new_log));
+}
+
+// 逐键比较事件序列，每个按键只报告第一处不同
+static void check_key_logs(void)
+{
+    for (int k = 0; k < MATRIX_KEY_NUM; k++) {
+        const KeyLog *ref = &s_ref_log[k];
+        const KeyLog *new = &s_new_log[k];
+        uint32_t n = (ref->n < new->n) ? ref->n : new->n;
+
+        CHECK(ref->n <= KEY_LOG_MAX);
+        CHECK(ref->n == new->n);
+        if (n > KEY_LOG_MAX) n = KEY_LOG_MAX;
+        for (uint32_t i = 0; i < n; i++) {
+            if (ref->type[i] != new->type[i] || ref->ms[i] != new->ms[i]) {
+                printf("key %d event %u: integrator type %u at %u ms, vertical counter type %u at %u ms\n",
+                       k, i, ref->type[i], ref->ms[i], new->type[i], new->ms[i]);
+                CHECK(ref->type[i] == new->type[i] && ref->ms[i] == new->ms[i]);
+                break;
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    struct timespec a, b;
+    double ref_ns = 1e9, new_ns = 1e9;
+    uint32_t totals[2][4] = {{0}};
+
+#ifdef MATRIX_EXTERNAL_LAYOUT
+    make_layout();
+#endif
+    make_trace();
+    new_reset();
+    make_snapshots();
+
+    // 各跑5遍取最短时间；事件数与事件序列取最后一遍
+    for (int rep = 0; rep < 5; rep++) {
+        ref_reset();
+        clock_gettime(CLOCK_MONOTONIC, &a);
+        for (int t = 0; t < TRACE_MS; t++) ref_scan(s_trace[t], (uint32_t)t + 1U);
+        clock_gettime(CLOCK_MONOTONIC, &b);
+        if (elapsed_ns(&a, &b) / TRACE_MS < ref_ns) ref_ns = elapsed_ns(&a, &b) / TRACE_MS;
+
+        new_reset();
+        clock_gettime(CLOCK_MONOTONIC, &a);
+        for (int t = 0; t < TRACE_MS; t++) {
+            process_snapshot(&s_snaps[t]);
+            new_drain();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &b);
+        if (elapsed_ns(&a, &b) / TRACE_MS < new_ns) new_ns = elapsed_ns(&a, &b) / TRACE_MS;
+    }
+
+    for (int k = 0; k < MATRIX_KEY_NUM; k++) {
+        for (int e = 0; e < 4; e++) {
+            totals[0][e] += s_ref_events[k][e];
+            totals[1][e] += s_new_events[k][e];
+        }
+        for (int e = 0; e < 4; e++) CHECK(s_ref_events[k][e] == s_new_events[k][e]);
+    }
+    check_key_logs();
+    CHECK(totals[1][KEY_EVENT_PRESS] > 1000U);
+    CHECK(MatrixKeyboard_GetEventOverflows() == 0U);
+
+    printf("debounce %dx%d, %d ms trace: integrator %.1f ns/scan, vertical counter %.1f ns/scan\n",
+           ROW_NUM, COL_NUM, TRACE_MS, ref_ns, new_ns);
+    printf("  events press/long/repeat/release: integrator %u/%u/%u/%u, vertical counter %u/%u/%u/%u\n",
+           totals[0][0], totals[0][1], totals[0][2], totals[0][3],
+           totals[1][0], totals[1][1], totals[1][2], totals[1][3]);
+    printf("test_debounce: %s\n", s_fails ? "FAILED" : "OK");
+    return s_fails != 0;
+}
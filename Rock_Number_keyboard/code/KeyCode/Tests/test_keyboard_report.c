@@ -0,0 +1,154 @@
+// keyboard_report 主机单元测试：6键边界、第7键溢出、按下顺序补位、重复按下/释放、无效键码、随机操作不变式
+#include "keyboard_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int s_fails = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); s_fails++; } \
+} while (0)
+
+// 与逐键扫描得到的结果比对内部索引
+static void check_invariants(const KeyboardReport *r)
+{
+    int held = 0;
+    int slotted = 0;
+
+    for (int k = 1; k < 0xE0; k++) {
+        if (KeyboardReport_HasKey(r, (uint8_t)k)) held++;
+        if (r->slot_of[k] != 0U) slotted++;
+    }
+    CHECK(held == r->key_count);
+    CHECK(r->slot_count == (held < 6 ? held : 6));
+    CHECK(slotted == r->slot_count);
+    for (int i = 0; i < r->slot_count; i++) {
+        CHECK(r->slot_of[r->slots[i]] == i + 1);
+        CHECK(KeyboardReport_HasKey(r, r->slots[i]));
+    }
+    for (int i = r->slot_count; i < 6; i++) CHECK(r->slots[i] == 0U);
+}
+
+static void test_rollover(void)
+{
+    KeyboardReport r;
+    uint8_t out[KEYBOARD_REPORT_NKRO_SIZE];
+
+    KeyboardReport_Init(&r);
+    CHECK(!KeyboardReport_IsDirty(&r));
+
+    // 重复按下、释放未按下的键、键码0：报告不变
+    CHECK(KeyboardReport_AddKey(&r, 0x04));
+    CHECK(KeyboardReport_IsDirty(&r));
+    KeyboardReport_ClearDirty(&r);
+    CHECK(!KeyboardReport_AddKey(&r, 0x04));
+    CHECK(!KeyboardReport_RemoveKey(&r, 0x05));
+    CHECK(!KeyboardReport_AddKey(&r, 0x00));
+    CHECK(!KeyboardReport_IsDirty(&r));
+
+    // 恰好6键
+    for (uint8_t k = 0x05; k <= 0x09; k++) CHECK(KeyboardReport_AddKey(&r, k));
+    CHECK(KeyboardReport_SerializeBoot(&r, out) == KEYBOARD_REPORT_BOOT_SIZE);
+    CHECK(out[2] == 0x04 && out[3] == 0x05 && out[7] == 0x09);
+
+    // 第7键：6个槽位全部为 ErrorRollOver，修饰键照常上报
+    CHECK(KeyboardReport_AddKey(&r, 0x0A));
+    CHECK(KeyboardReport_AddKey(&r, 0xE1));
+    KeyboardReport_SerializeBoot(&r, out);
+    CHECK(out[0] == 0x02);
+    for (int i = 2; i < 8; i++) CHECK(out[i] == 0x01);
+    check_invariants(&r);
+
+    // 回到6键：溢出的键按按下顺序补到末尾
+    CHECK(KeyboardReport_RemoveKey(&r, 0x06));
+    KeyboardReport_SerializeBoot(&r, out);
+    CHECK(out[2] == 0x04 && out[3] == 0x05 && out[4] == 0x07 &&
+          out[5] == 0x08 && out[6] == 0x09 && out[7] == 0x0A);
+    check_invariants(&r);
+
+    CHECK(KeyboardReport_RemoveKey(&r, 0x0A));
+    KeyboardReport_SerializeBoot(&r, out);
+    CHECK(out[6] == 0x09 && out[7] == 0x00);
+    check_invariants(&r);
+
+    CHECK(KeyboardReport_SerializeNkro(&r, 1, out) == KEYBOARD_REPORT_NKRO_SIZE);
+    CHECK(out[0] == 1 && out[1] == 0x02);
+    CHECK(out[2] == ((1U << 4) | (1U << 5) | (1U << 7)));
+
+    CHECK(KeyboardReport_Clear(&r));
+    CHECK(!KeyboardReport_Clear(&r));
+    check_invariants(&r);
+}
+
+static void test_invalid_codes(void)
+{
+    KeyboardReport r;
+    uint8_t out[KEYBOARD_REPORT_BOOT_SIZE];
+
+    KeyboardReport_Init(&r);
+
+    // 0xE8-0xFF 不能按低3位落到修饰键上（0xE8 曾被当作 Left Ctrl）
+    for (int k = 0xE8; k <= 0xFF; k++) {
+        CHECK(!KeyboardReport_AddKey(&r, (uint8_t)k));
+        CHECK(!KeyboardReport_HasKey(&r, (uint8_t)k));
+    }
+    CHECK(r.modifier == 0U && r.key_count == 0U);
+    CHECK(!KeyboardReport_IsDirty(&r));
+
+    // 已按下的修饰键不会被无效键码释放
+    CHECK(KeyboardReport_AddKey(&r, 0xE0));
+    for (int k = 0xE8; k <= 0xFF; k++) CHECK(!KeyboardReport_RemoveKey(&r, (uint8_t)k));
+    CHECK(KeyboardReport_HasKey(&r, 0xE0));
+    KeyboardReport_SerializeBoot(&r, out);
+    CHECK(out[0] == 0x01);
+}
+
+static void test_random(void)
+{
+    KeyboardReport r;
+    bool ref[0xE8] = {false};
+
+    KeyboardReport_Init(&r);
+    srand(1);
+    for (int it = 0; it < 200000; it++) {
+        uint8_t k = (uint8_t)(1 + rand() % 0xE7);
+        bool add = (rand() & 1) != 0;
+        bool changed = add ? KeyboardReport_AddKey(&r, k) : KeyboardReport_RemoveKey(&r, k);
+
+        CHECK(changed == (add != ref[k]));
+        ref[k] = add;
+        if (it % 97 == 0) check_invariants(&r);
+        if (s_fails > 5) return;
+    }
+    for (int k = 1; k < 0xE8; k++) CHECK(KeyboardReport_HasKey(&r, (uint8_t)k) == ref[k]);
+    check_invariants(&r);
+}
+
+static void bench_add_remove(void)
+{
+    KeyboardReport r;
+    struct timespec a, b;
+    const int n = 10000000;
+
+    KeyboardReport_Init(&r);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (int it = 0; it < n; it++) {
+        KeyboardReport_AddKey(&r, (uint8_t)(4 + (it & 31)));
+        KeyboardReport_RemoveKey(&r, (uint8_t)(4 + ((it + 7) & 31)));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    printf("keyboard_report: add+remove %.1f ns/pair\n",
+           ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / n);
+}
+
+int main(void)
+{
+    test_rollover();
+    test_invalid_codes();
+    test_random();
+    bench_add_remove();
+    printf("test_keyboard_report: %s\n", s_fails ? "FAILED" : "OK");
+    return s_fails != 0;
+}
@@ -0,0 +1,352 @@
+// 灯效定点数学主机测试：
+// 1. led_math：Sin16 全部65536个相位与 libm 的误差不超过 4/32767，缩放/混合两端、缓动曲线单调且两端固定、HSV 与浮点计算的误差；
+// 2. 灯效等价：ws2812.c 的呼吸/波浪/按键渐变逐步与改造前的浮点公式（参考模型）比较每个通道的最大差值，
+//    彩虹与理想浮点 HSV 比较（改造前的 hsv_to_rgb 把 0~359° 当作 0~255 使用，不作为参考）；
+// 3. 每帧绘制耗时：参考模型与 WS2812_ProcessEffects()（都含提交时复制一帧，不含编码）。
+// 直接包含被测源文件，以便读取帧缓冲并逐帧驱动效果。
+#include "../Core/Src/ws2812.c"
+#include "hal_stub.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_FRAMES 100000
+
+static int s_fails = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); s_fails++; } \
+} while (0)
+
+static const uint8_t s_brightness[] = { 37, 50, 100 };
+
+// ---- led_math ----
+static void test_sin16(void)
+{
+    int max_err = 0;
+
+    for (uint32_t p = 0; p < 65536U; p++) {
+        int ref = (int)lround(32767.0 * sin(p * (2.0 * M_PI / 65536.0)));
+        int err = abs(LedMath_Sin16((uint16_t)p) - ref);
+        if (err > max_err) max_err = err;
+        CHECK(LedMath_Cos16((uint16_t)p) == LedMath_Sin16((uint16_t)(p + 16384U)));
+    }
+    CHECK(max_err <= 4);
+    CHECK(LedMath_Sin16(0) == 0);
+    CHECK(LedMath_Sin16(16384) == 32767);
+    CHECK(LedMath_Sin16(49152) == -32767);
+    CHECK(LedMath_Sin8(0) == 128 && LedMath_Sin8(16384) == 255);
+    printf("led_math: Sin16 max error %d/32767\n", max_err);
+}
+
+static void test_scale_blend_ease(void)
+{
+    uint8_t prev_quad = 0;
+    uint8_t prev_cubic = 0;
+    uint8_t v[256];
+
+    for (int a = 0; a < 256; a++) {
+        CHECK(LedMath_Scale8((uint8_t)a, 255) == a);
+        CHECK(LedMath_Scale8((uint8_t)a, 0) == 0);
+        for (int b = 0; b < 256; b += 17) {
+            CHECK(LedMath_Blend8((uint8_t)a, (uint8_t)b, 0) == a);
+            CHECK(LedMath_Blend8((uint8_t)a, (uint8_t)b, 255) == b);
+        }
+        v[a] = (uint8_t)a;
+    }
+    LedMath_NScale8(v, 256, 100);
+    for (int a = 0; a < 256; a++) CHECK(v[a] == LedMath_Scale8((uint8_t)a, 100));
+
+    // 缓动曲线单调不减，两端为 0 与 255
+    CHECK(LedMath_EaseInOutQuad8(0) == 0 && LedMath_EaseInOutQuad8(255) == 255);
+    CHECK(LedMath_EaseInOutCubic8(0) == 0 && LedMath_EaseInOutCubic8(255) == 255);
+    for (int t = 0; t < 256; t++) {
+        uint8_t quad = LedMath_EaseInOutQuad8((uint8_t)t);
+        uint8_t cubic = LedMath_EaseInOutCubic8((uint8_t)t);
+        CHECK(quad >= prev_quad);
+        CHECK(cubic >= prev_cubic);
+        prev_quad = quad;
+        prev_cubic = cubic;
+    }
+}
+
+// 理想HSV（色相 0~360°，饱和度1），结果 0~val
+static void hsv_float(double hue, double val, double rgb[3])
+{
+    double h = fmod(hue, 360.0) / 60.0;
+    int region = (int)h;
+    double f = h - region;
+    double q = val * (1.0 - f);
+    double t = val * f;
+
+    switch (region) {
+        case 0:  rgb[0] = val; rgb[1] = t;   rgb[2] = 0;   break;
+        case 1:  rgb[0] = q;   rgb[1] = val; rgb[2] = 0;   break;
+        case 2:  rgb[0] = 0;   rgb[1] = val; rgb[2] = t;   break;
+        case 3:  rgb[0] = 0;   rgb[1] = q;   rgb[2] = val; break;
+        case 4:  rgb[0] = t;   rgb[1] = 0;   rgb[2] = val; break;
+        default: rgb[0] = val; rgb[1] = 0;   rgb[2] = q;   break;
+    }
+}
+
+static void test_hsv(void)
+{
+    double max_err = 0;
+
+    for (int hue = 0; hue < 256; hue++) {
+        for (int val = 0; val < 256; val += 5) {
+            uint8_t rgb[3];
+            double ref[3];
+
+            LedMath_HsvToRgb((uint8_t)hue, 255, (uint8_t)val, &rgb[0], &rgb[1], &rgb[2]);
+            hsv_float(hue * 360.0 / 256.0, val, ref);
+            for (int c = 0; c < 3; c++) {
+                if (fabs(rgb[c] - ref[c]) > max_err) max_err = fabs(rgb[c] - ref[c]);
+            }
+
+            LedMath_HsvToRgb((uint8_t)hue, 0, (uint8_t)val, &rgb[0], &rgb[1], &rgb[2]);
+            CHECK(rgb[0] == val && rgb[1] == val && rgb[2] == val);
+        }
+    }
+    CHECK(max_err <= 1.0);
+    printf("led_math: HsvToRgb max error %.2f\n", max_err);
+}
+
+// ---- 参考模型：改造前的浮点灯效，亮度按 v * brightness / 100 ----
+static uint8_t s_ref[WS2812_LED_NUM * 3];   // GRB，与帧缓冲相同
+static uint8_t s_ref_front[WS2812_LED_NUM * 3];
+
+static void ref_set(int i, uint8_t r, uint8_t g, uint8_t b, uint8_t bright)
+{
+    s_ref[i * 3 + 0] = (uint8_t)(g * bright / 100);
+    s_ref[i * 3 + 1] = (uint8_t)(r * bright / 100);
+    s_ref[i * 3 + 2] = (uint8_t)(b * bright / 100);
+}
+
+static void ref_breathing(uint32_t step, uint8_t bright)
+{
+    float breath = (sin(step * 0.1f) + 1.0f) * 0.5f;
+    uint8_t bb = (uint8_t)(breath * bright);
+    uint8_t c = (uint8_t)(bb * 255 / 100);
+
+    for (int i = 0; i < WS2812_LED_NUM; i++) ref_set(i, c, c, c, bright);
+}
+
+static void ref_wave(uint32_t step, uint8_t bright)
+{
+    for (int i = 0; i < WS2812_LED_NUM; i++) {
+        float wave = sin((step + i * 2) * 0.3f);
+        uint8_t wb = (uint8_t)((wave + 1.0f) * 0.5f * bright * 255 / 100);
+        ref_set(i, 0, wb, wb, bright);
+    }
+}
+
+static void ref_reactive(const uint8_t *fade_left, uint8_t bright)
+{
+    for (int i = 0; i < WS2812_LED_NUM; i++) {
+        if (fade_left[i] > 0) {
+            uint8_t fade = (uint8_t)(fade_left[i] * 255 / WS2812_FADE_STEPS);
+            ref_set(i, fade, fade, fade, bright);
+        }
+    }
+}
+
+// 改造前的彩虹（含色相范围错误），只用于比较耗时
+static void ref_rainbow(uint32_t step, uint8_t bright)
+{
+    for (int i = 0; i < WS2812_LED_NUM; i++) {
+        uint16_t hue = (uint16_t)((step * 5 + i * 360 / WS2812_LED_NUM) % 360);
+        uint8_t val = (uint8_t)(bright * 255 / 100);
+        uint8_t region = (uint8_t)(hue / 43);
+        uint8_t remainder = (uint8_t)((hue - (region * 43)) * 6);
+        uint8_t p = 0;
+        uint8_t q = (uint8_t)((val * (255 - ((255 * remainder) >> 8))) >> 8);
+        uint8_t t = (uint8_t)((val * (255 - ((255 * (255 - remainder)) >> 8))) >> 8);
+
+        switch (region) {
+            case 0:  ref_set(i, val, t, p, bright);   break;
+            case 1:  ref_set(i, q, val, p, bright);   break;
+            case 2:  ref_set(i, p, val, t, bright);   break;
+            case 3:  ref_set(i, p, q, val, bright);   break;
+            case 4:  ref_set(i, t, p, val, bright);   break;
+            default: ref_set(i, val, p, q, bright);   break;
+        }
+    }
+}
+
+// ---- 被测：按步驱动 WS2812_ProcessEffects()，DMA保持忙，提交只交换缓冲不编码 ----
+static void fx_start(WS2812_Mode mode, uint8_t bright)
+{
+    WS2812_Init();
+    ws2812_updating = 1;
+    stub_tick_ms = 1000;
+    WS2812_SetBrightness(bright);
+    WS2812_SetMode(mode);
+}
+
+static const uint8_t *fx_render(uint32_t step, uint32_t step_ms)
+{
+    stub_tick_ms = effect_timer + step * step_ms;
+    ws2812_frame_due = 1;
+    WS2812_ProcessEffects();
+    return ws2812_led_buffer;  // 提交后后台缓冲是刚提交帧的副本
+}
+
+static int max_diff(const uint8_t *a, const uint8_t *b)
+{
+    int d = 0;
+
+    for (int i = 0; i < WS2812_LED_NUM * 3; i++) {
+        if (abs(a[i] - b[i]) > d) d = abs(a[i] - b[i]);
+    }
+    return d;
+}
+
+static void test_effects(void)
+{
+    for (unsigned n = 0; n < sizeof(s_brightness); n++) {
+        uint8_t b = s_brightness[n];
+        int breath_d = 0, wave_d = 0, fade_d = 0;
+        double rainbow_err = 0;
+        uint8_t fade_left[WS2812_LED_NUM] = {0};
+
+        fx_start(WS2812_MODE_BREATHING, b);
+        for (uint32_t s = 0; s < WS2812_BREATH_STEPS; s++) {
+            const uint8_t *out = fx_render(s, WS2812_BREATH_STEP_MS);
+            ref_breathing(s, b);
+            if (max_diff(out, s_ref) > breath_d) breath_d = max_diff(out, s_ref);
+        }
+
+        fx_start(WS2812_MODE_WAVE, b);
+        for (uint32_t s = 0; s < WS2812_WAVE_STEPS; s++) {
+            const uint8_t *out = fx_render(s, WS2812_WAVE_STEP_MS);
+            ref_wave(s, b);
+            if (max_diff(out, s_ref) > wave_d) wave_d = max_diff(out, s_ref);
+        }
+
+        // 按键渐变：按下 (0,0) 与 (2,1)，之后每步渐暗一级直到熄灭
+        fx_start(WS2812_MODE_KEY_REACTIVE, b);
+        fx_render(0, WS2812_FADE_STEP_MS);
+        WS2812_OnKeyPress(0, 0);
+        WS2812_OnKeyPress(2, 1);
+        fade_left[0] = WS2812_FADE_STEPS;
+        fade_left[2 * 4 + 1] = WS2812_FADE_STEPS;
+        memset(s_ref, 0, sizeof(s_ref));
+        for (uint32_t s = 1; s <= WS2812_FADE_STEPS; s++) {
+            const uint8_t *out = fx_render(s, WS2812_FADE_STEP_MS);
+            fade_left[0]--;
+            fade_left[2 * 4 + 1]--;
+            ref_reactive(fade_left, b);
+            for (int i = 0; i < WS2812_LED_NUM; i++) {
+                if (fade_left[i] == 0 && (i == 0 || i == 2 * 4 + 1)) ref_set(i, 0, 0, 0, b);
+            }
+            if (max_diff(out, s_ref) > fade_d) fade_d = max_diff(out, s_ref);
+        }
+
+        // 彩虹与理想HSV比较：值为 亮度*255/100，写入时再按亮度缩放一次
+        fx_start(WS2812_MODE_RAINBOW, b);
+        for (uint32_t s = 0; s < WS2812_RAINBOW_STEPS; s++) {
+            const uint8_t *out = fx_render(s, WS2812_RAINBOW_STEP_MS);
+            for (int i = 0; i < WS2812_LED_NUM; i++) {
+                double rgb[3];
+                hsv_float(s * 5.0 + i * 360.0 / WS2812_LED_NUM, b * 255.0 / 100.0 * b / 100.0, rgb);
+                double e[3] = { fabs(out[i * 3 + 1] - rgb[0]), fabs(out[i * 3 + 0] - rgb[1]), fabs(out[i * 3 + 2] - rgb[2]) };
+                for (int c = 0; c < 3; c++) {
+                    if (e[c] > rainbow_err) rainbow_err = e[c];
+                }
+            }
+        }
+
+        CHECK(breath_d <= 3);
+        CHECK(wave_d <= 1);
+        CHECK(fade_d <= 1);
+        CHECK(rainbow_err <= 7.0);
+        printf("effects @%3u%%: max channel difference breathing %d, wave %d, reactive %d; rainbow vs ideal HSV %.1f\n",
+               b, breath_d, wave_d, fade_d, rainbow_err);
+    }
+}
+
+static double elapsed_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+static void bench_effects(void)
+{
+    static const struct {
+        const char *name;
+        WS2812_Mode mode;
+        uint32_t step_ms;
+        uint32_t steps;
+    } fx[] = {
+        { "breathing", WS2812_MODE_BREATHING, WS2812_BREATH_STEP_MS, WS2812_BREATH_STEPS },
+        { "rainbow", WS2812_MODE_RAINBOW, WS2812_RAINBOW_STEP_MS, WS2812_RAINBOW_STEPS },
+        { "reactive", WS2812_MODE_KEY_REACTIVE, WS2812_FADE_STEP_MS, 1 },
+        { "wave", WS2812_MODE_WAVE, WS2812_WAVE_STEP_MS, WS2812_WAVE_STEPS },
+    };
+    struct timespec a, b;
+    uint8_t fade_all[WS2812_LED_NUM];
+    volatile uint32_t sink = 0;
+    double frame_ns = 1e9;
+
+    // 新方式的数字包含每帧固定开销（帧调度、计时与提交），参考模型只有绘制和一次拷贝；
+    // 先单独测出固定开销：静态模式强制处理一帧，只多一次提交
+    fx_start(WS2812_MODE_STATIC, 50);
+    for (int rep = 0; rep < 5; rep++) {
+        clock_gettime(CLOCK_MONOTONIC, &a);
+        for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+            ws2812_dirty = 1;
+            sink += fx_render(0, 1)[0];
+        }
+        clock_gettime(CLOCK_MONOTONIC, &b);
+        if (elapsed_ns(&a, &b) / BENCH_FRAMES < frame_ns) frame_ns = elapsed_ns(&a, &b) / BENCH_FRAMES;
+    }
+
+    memset(fade_all, WS2812_FADE_STEPS / 2, sizeof(fade_all));
+    printf("effects per frame, %d LEDs @50%% (new figures include %.0f ns frame overhead):", WS2812_LED_NUM, frame_ns);
+    for (unsigned f = 0; f < sizeof(fx) / sizeof(fx[0]); f++) {
+        double ref_ns = 1e9, new_ns = 1e9;
+
+        // 各跑5遍取最短时间；每帧都强制重绘（按键渐变所有LED都在渐变中、不推进步数）
+        for (int rep = 0; rep < 5; rep++) {
+            clock_gettime(CLOCK_MONOTONIC, &a);
+            for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+                uint32_t s = n % fx[f].steps;
+                switch (fx[f].mode) {
+                    case WS2812_MODE_BREATHING: ref_breathing(s, 50); break;
+                    case WS2812_MODE_RAINBOW:   ref_rainbow(s, 50);   break;
+                    case WS2812_MODE_WAVE:      ref_wave(s, 50);      break;
+                    default:                    ref_reactive(fade_all, 50); break;
+                }
+                memcpy(s_ref_front, s_ref, sizeof(s_ref));
+                sink += s_ref_front[n % sizeof(s_ref_front)];
+            }
+            clock_gettime(CLOCK_MONOTONIC, &b);
+            if (elapsed_ns(&a, &b) / BENCH_FRAMES < ref_ns) ref_ns = elapsed_ns(&a, &b) / BENCH_FRAMES;
+
+            fx_start(fx[f].mode, 50);
+            memcpy(led_fade, fade_all, sizeof(led_fade));
+            clock_gettime(CLOCK_MONOTONIC, &a);
+            for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+                effect_restart = 1;
+                sink += fx_render(fx[f].mode == WS2812_MODE_KEY_REACTIVE ? 0 : n % fx[f].steps, fx[f].step_ms)[0];
+            }
+            clock_gettime(CLOCK_MONOTONIC, &b);
+            if (elapsed_ns(&a, &b) / BENCH_FRAMES < new_ns) new_ns = elapsed_ns(&a, &b) / BENCH_FRAMES;
+        }
+        printf(" %s %.0f -> %.0f ns%s", fx[f].name, ref_ns, new_ns, (f + 1 < sizeof(fx) / sizeof(fx[0])) ? "," : "\n");
+    }
+    (void)sink;
+}
+
+int main(void)
+{
+    test_sin16();
+    test_scale_blend_ease();
+    test_hsv();
+    test_effects();
+    bench_effects();
+    printf("test_led_math: %s\n", s_fails ? "FAILED" : "OK");
+    return s_fails ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+// WS2812 编码主机测试：WS2812_Present() 发送的比较值与改造前的逐位编码（参考模型）逐个比对，
+// 包括 Num Lock 指示LED（GRB 绿色）与复位低电平。
+// 整帧方式（默认）检查DMA缓冲区，并比较两种编码每个LED的耗时；
+// 流式方式（Makefile 以 -DWS2812_DMA_STREAM=1 另行编译）模拟循环DMA逐个触发半满/全满中断，
+// 检查每次填入的半缓冲区、帧尾的复位组、发送完毕时停止以及排队帧的紧接发送。
+// 直接包含被测源文件，以便直接调用 ws2812_encode_led() 与读取帧缓冲。
+#include "../Core/Src/ws2812.c"
+#include "hal_stub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_FRAMES 200000
+
+static int s_fails = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); s_fails++; } \
+} while (0)
+
+// ---- 参考模型：改造前每个颜色位一次判断、一个半字的编码 ----
+#if !(WS2812_DMA_STREAM)
+static uint16_t s_ref_buffer[WS2812_LED_NUM * WS2812_BITS_PER_LED + WS2812_RESET_BITS];
+#endif
+
+static void ref_encode(uint16_t *dst, const uint8_t *grb_frame, const uint8_t *indicator)
+{
+    uint16_t dma_index = 0;
+
+    for (int led = 0; led < WS2812_LED_NUM; led++) {
+        const uint8_t *grb = &grb_frame[led * 3];
+        if (led == WS2812_NUM_LOCK_LED && indicator != NULL) {
+            grb = indicator;
+        }
+        for (int byte = 0; byte < 3; byte++) {
+            uint8_t color_byte = grb[byte];
+            for (int bit = 7; bit >= 0; bit--) {
+                dst[dma_index++] = (color_byte & (1 << bit)) ? WS2812_1_CODE : WS2812_0_CODE;
+            }
+        }
+    }
+    for (int i = 0; i < WS2812_RESET_BITS; i++) {
+        dst[dma_index++] = 0;
+    }
+}
+
+// 用随机颜色画一帧并提交；返回本帧的GRB数据
+static void present_random(uint8_t *grb_out)
+{
+    for (int led = 0; led < WS2812_LED_NUM; led++) {
+        WS2812_SetColor((uint16_t)led, (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand());
+    }
+    memcpy(grb_out, ws2812_led_buffer, WS2812_LED_NUM * 3);
+    WS2812_Present();
+}
+
+#if (WS2812_DMA_STREAM)
+#define STREAM_HALVES (WS2812_STREAM_DATA_HALVES + WS2812_STREAM_RESET_HALVES)
+#define HALF_BITS     (WS2812_STREAM_HALF_WORDS * 2)
+
+// 线上发送的比较值（半字），一帧最多 STREAM_HALVES 个半缓冲区
+static uint16_t s_wire[STREAM_HALVES * HALF_BITS];
+static uint16_t s_expect[STREAM_HALVES * HALF_BITS];
+
+// 模拟循环DMA发送当前帧：先记下正在发送的一半，再触发这一半的半满/全满中断；
+// DMA停止或紧接着开始下一帧时结束，返回本帧发送的半缓冲区数
+static int stream_run(void)
+{
+    uint32_t frame = ws2812_frames_presented;
+    uint8_t cur = 0;
+    int halves = 0;
+
+    CHECK(stub_pwm_data == ws2812_dma_buffer);
+    CHECK(stub_pwm_length == WS2812_DMA_BUFFER_SIZE);
+    while (stub_pwm_running && ws2812_frames_presented == frame) {
+        if (halves == STREAM_HALVES) {
+            CHECK(halves < STREAM_HALVES);  // 复位组发完后必须停止
+            break;
+        }
+        memcpy(&s_wire[halves * HALF_BITS], &ws2812_dma_buffer[cur * WS2812_STREAM_HALF_WORDS],
+               WS2812_STREAM_HALF_WORDS * sizeof(uint32_t));
+        halves++;
+        if (cur == 0U) {
+            HAL_TIM_PWM_PulseFinishedHalfCpltCallback(&htim4);
+        } else {
+            HAL_TIM_PWM_PulseFinishedCallback(&htim4);
+        }
+        cur ^= 1U;
+    }
+    return halves;
+}
+
+// 一帧的线上数据：全部LED组（最后一组不足时补0），随后 WS2812_STREAM_RESET_HALVES 个全零组
+static void check_wire(int halves, const uint8_t *grb_frame, const uint8_t *indicator)
+{
+    int zeros = 0;
+
+    memset(s_expect, 0, sizeof(s_expect));
+    ref_encode(s_expect, grb_frame, indicator);
+    CHECK(halves == STREAM_HALVES);
+    CHECK(memcmp(s_wire, s_expect, sizeof(s_wire)) == 0);
+    for (int i = WS2812_STREAM_DATA_HALVES * HALF_BITS; i < STREAM_HALVES * HALF_BITS; i++) {
+        CHECK(s_wire[i] == 0U);
+    }
+    for (int i = STREAM_HALVES * HALF_BITS - 1; i >= 0 && s_wire[i] == 0U; i--) zeros++;
+    CHECK(zeros >= WS2812_RESET_BITS);
+}
+
+static void test_encode(void)
+{
+    uint8_t grb[3][WS2812_LED_NUM * 3];
+    uint32_t presented;
+    uint32_t dropped;
+
+    WS2812_Init();
+    WS2812_SetBrightness(100);
+    for (int i = 0; i < 200; i++) {
+        present_random(grb[0]);
+        CHECK(stub_pwm_running);
+        check_wire(stream_run(), grb[0], NULL);
+        CHECK(!stub_pwm_running);
+        CHECK(ws2812_updating == 0U);
+    }
+
+    // Num Lock 打开：0号LED按当前亮度显示绿色（GRB 的第一个字节）
+    for (uint8_t b = 0; b <= 100; b += 25) {
+        uint8_t green[3] = { LedMath_Scale8(255, (uint8_t)(b * 255U / 100U)), 0, 0 };
+
+        WS2812_SetBrightness(b);
+        WS2812_SetLockIndicators(WS2812_LOCK_NUM);
+        present_random(grb[0]);
+        check_wire(stream_run(), grb[0], green);
+        WS2812_SetLockIndicators(0);
+    }
+
+    // 发送期间提交两帧：前一帧被替换，最后一帧在停止的同一中断中紧接着开始发送
+    WS2812_SetBrightness(100);
+    presented = ws2812_frames_presented;
+    dropped = ws2812_frames_dropped;
+    present_random(grb[0]);
+    present_random(grb[1]);
+    present_random(grb[2]);
+    CHECK(ws2812_frames_dropped == dropped + 1U);
+    check_wire(stream_run(), grb[0], NULL);
+    CHECK(stub_pwm_running);
+    CHECK(ws2812_frames_presented == presented + 2U);
+    check_wire(stream_run(), grb[2], NULL);
+    CHECK(!stub_pwm_running);
+    CHECK(ws2812_updating == 0U);
+}
+#else
+// DMA缓冲区按半字（小端，与 Cortex-M 相同）与参考编码比对，随后模拟DMA发送完成
+static void check_dma_buffer(const uint8_t *grb_frame, const uint8_t *indicator)
+{
+    const uint16_t *half = (const uint16_t *)stub_pwm_data;
+
+    ref_encode(s_ref_buffer, grb_frame, indicator);
+    CHECK(stub_pwm_data == ws2812_dma_buffer);
+    CHECK(stub_pwm_length == WS2812_DMA_BUFFER_SIZE);
+    CHECK(memcmp(half, s_ref_buffer, sizeof(s_ref_buffer)) == 0);
+    HAL_TIM_PWM_PulseFinishedCallback(&htim4);
+}
+
+static void test_encode(void)
+{
+    uint8_t grb[WS2812_LED_NUM * 3];
+
+    WS2812_Init();
+    WS2812_SetBrightness(100);
+    for (int i = 0; i < 1000; i++) {
+        present_random(grb);
+        check_dma_buffer(grb, NULL);
+    }
+
+    // Num Lock 打开：0号LED按当前亮度显示绿色（GRB 的第一个字节）
+    for (uint8_t b = 0; b <= 100; b += 25) {
+        uint8_t green[3] = { LedMath_Scale8(255, (uint8_t)(b * 255U / 100U)), 0, 0 };
+
+        WS2812_SetBrightness(b);
+        WS2812_SetLockIndicators(WS2812_LOCK_NUM);
+        present_random(grb);
+        check_dma_buffer(grb, green);
+        WS2812_SetLockIndicators(0);
+    }
+}
+#endif
+
+#if !(WS2812_DMA_STREAM)
+static double elapsed_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+static void bench_encode(void)
+{
+    static uint8_t frames[16][WS2812_LED_NUM * 3];
+    struct timespec a, b;
+    double ref_ns = 1e9, lut_ns = 1e9;
+    volatile uint32_t sink = 0;
+
+    for (int f = 0; f < 16; f++) {
+        for (int i = 0; i < WS2812_LED_NUM * 3; i++) frames[f][i] = (uint8_t)rand();
+    }
+
+    // 各跑5遍取最短时间；只计编码本身（整帧加复位位），不含帧交换与DMA启动
+    for (int rep = 0; rep < 5; rep++) {
+        clock_gettime(CLOCK_MONOTONIC, &a);
+        for (int n = 0; n < BENCH_FRAMES; n++) {
+            ref_encode(s_ref_buffer, frames[n & 15], NULL);
+            sink += s_ref_buffer[n % WS2812_LED_NUM];
+        }
+        clock_gettime(CLOCK_MONOTONIC, &b);
+        if (elapsed_ns(&a, &b) / BENCH_FRAMES / WS2812_LED_NUM < ref_ns) {
+            ref_ns = elapsed_ns(&a, &b) / BENCH_FRAMES / WS2812_LED_NUM;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &a);
+        for (int n = 0; n < BENCH_FRAMES; n++) {
+            uint32_t *dst = ws2812_dma_buffer;
+            for (int led = 0; led < WS2812_LED_NUM; led++) {
+                ws2812_encode_led(dst, &frames[n & 15][led * 3]);
+                dst += WS2812_BITS_PER_LED / 2;
+            }
+            for (int i = 0; i < WS2812_RESET_BITS / 2; i++) *dst++ = 0;
+            sink += ws2812_dma_buffer[n % WS2812_LED_NUM];
+        }
+        clock_gettime(CLOCK_MONOTONIC, &b);
+        if (elapsed_ns(&a, &b) / BENCH_FRAMES / WS2812_LED_NUM < lut_ns) {
+            lut_ns = elapsed_ns(&a, &b) / BENCH_FRAMES / WS2812_LED_NUM;
+        }
+    }
+    (void)sink;
+
+    printf("ws2812 encode, %d LEDs: bit loop %.1f ns/LED, lookup table %.1f ns/LED\n",
+           WS2812_LED_NUM, ref_ns, lut_ns);
+}
+#endif
+
+int main(void)
+{
+    srand(1);
+    test_encode();
+#if (WS2812_DMA_STREAM)
+    printf("test_ws2812_encode (stream, %d LEDs per buffer): %s\n", WS2812_STREAM_LEDS, s_fails ? "FAILED" : "OK");
+#else
+    bench_encode();
+    printf("test_ws2812_encode: %s\n", s_fails ? "FAILED" : "OK");
+#endif
+    return s_fails ? 1 : 0;
+}
@@ -24,6 +24,7 @@
 #include "usbd_core.h"
 #include "usbd_desc.h"
 #include "usbd_hid.h"
+#include "usbd_cdc_console.h"
 
 /* USER CODE BEGIN Includes */
 
@@ -71,7 +72,12 @@ void MX_USB_DEVICE_Init(void)
   {
     Error_Handler();
   }
+#if (USBD_CDC_CONSOLE == 1U)
+  /* Keyboard-only HID plus the CDC-ACM console (usbd_cdc_console.c) */
+  if (USBD_RegisterClass(&hUsbDeviceFS, &USBD_HID_CDC) != USBD_OK)
+#else
   if (USBD_RegisterClass(&hUsbDeviceFS, &USBD_HID) != USBD_OK)
+#endif /* USBD_CDC_CONSOLE */
   {
     Error_Handler();
   }
@@ -0,0 +1,630 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_console.c
+  * @brief          : CDC-ACM diagnostic console and keyboard + console class
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  * @verbatim
+  *
+  *          ===================================================================
+  *                          CDC Console Description
+  *          ===================================================================
+  *           Built with USBD_CDC_CONSOLE. The device core drives a single
+  *           class, so USBD_HID_CDC is registered instead of USBD_HID: it
+  *           appends a CDC-ACM function behind an IAD to the configuration of
+  *           the keyboard-only HID class and routes each request and endpoint
+  *           event to the function that owns it:
+  *             - Interface 0: boot keyboard, handled by USBD_HID (EP1 IN / EP1 OUT)
+  *             - Interface 1: CDC communication, notification EP2 IN
+  *             - Interface 2: CDC data, bulk EP3 IN / EP3 OUT
+  *           The line coding is only stored and reported back; output is held
+  *           until the host asserts DTR.
+  *
+  *  @endverbatim
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_cdc_console.h"
+#include "usbd_ctlreq.h"
+
+#if (USBD_CDC_CONSOLE == 1U)
+
+#if (USBD_HID_KEYBOARD_ONLY == 0U)
+#error "USBD_CDC_CONSOLE needs EP2/EP3: set USBD_HID_KEYBOARD_ONLY"
+#endif
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_CDC_CONSOLE
+  * @brief CDC-ACM diagnostic console next to the boot keyboard
+  * @{
+  */
+
+/** @defgroup USBD_CDC_CONSOLE_Private_TypesDefinitions
+  * @{
+  */
+typedef struct
+{
+  uint8_t Tx[CDC_DATA_EP_SIZE];        /* bulk IN packet being sent */
+  uint8_t Rx[CDC_DATA_EP_SIZE];        /* bulk OUT packet buffer */
+  uint8_t LineCoding[CDC_LINE_CODING_SIZE]; /* kept for GET_LINE_CODING only */
+  uint8_t LineState;                   /* SET_CONTROL_LINE_STATE bits */
+  uint8_t TxLen;                       /* length of the packet in flight */
+  uint8_t TxBusy;
+  uint8_t CtlPending;                  /* SET_LINE_CODING data stage in progress */
+  uint8_t AltSetting;
+} USBD_CDC_Console_HandleTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CDC_CONSOLE_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_HID_CDC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_HID_CDC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_HID_CDC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_HID_CDC_EP0_RxReady(USBD_HandleTypeDef *pdev);
+static uint8_t USBD_HID_CDC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_HID_CDC_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_HID_CDC_SOF(USBD_HandleTypeDef *pdev);
+static uint8_t *USBD_HID_CDC_GetFSCfgDesc(uint16_t *length);
+static uint8_t *USBD_HID_CDC_GetHSCfgDesc(uint16_t *length);
+static uint8_t *USBD_HID_CDC_GetOtherSpeedCfgDesc(uint16_t *length);
+static uint8_t *USBD_HID_CDC_GetDeviceQualifierDesc(uint16_t *length);
+static uint8_t *USBD_HID_CDC_BuildCfgDesc(const uint8_t *hid_desc, uint16_t hid_len, uint16_t *length);
+static USBD_StatusTypeDef USBD_CDC_Console_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static void USBD_CDC_Console_TxNext(USBD_HandleTypeDef *pdev);
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CDC_CONSOLE_Private_Variables
+  * @{
+  */
+
+USBD_ClassTypeDef USBD_HID_CDC =
+{
+  USBD_HID_CDC_Init,
+  USBD_HID_CDC_DeInit,
+  USBD_HID_CDC_Setup,
+  NULL,                     /* EP0_TxSent */
+  USBD_HID_CDC_EP0_RxReady, /* EP0_RxReady */
+  USBD_HID_CDC_DataIn,      /* DataIn */
+  USBD_HID_CDC_DataOut,     /* DataOut */
+  USBD_HID_CDC_SOF,         /* SOF */
+  NULL,
+  NULL,
+  USBD_HID_CDC_GetHSCfgDesc,
+  USBD_HID_CDC_GetFSCfgDesc,
+  USBD_HID_CDC_GetOtherSpeedCfgDesc,
+  USBD_HID_CDC_GetDeviceQualifierDesc,
+};
+
+/* Console function, appended to the HID configuration descriptor */
+static const uint8_t USBD_CDC_Console_Desc[USB_CDC_CONSOLE_DESC_SIZ] =
+{
+  /************** Interface Association of the CDC console ****************/
+  0x08,                                               /* bLength: IAD size */
+  0x0B,                                               /* bDescriptorType: Interface Association */
+  CDC_ITF_COMM,                                       /* bFirstInterface */
+  0x02,                                               /* bInterfaceCount */
+  0x02,                                               /* bFunctionClass: CDC */
+  0x02,                                               /* bFunctionSubClass: ACM */
+  0x01,                                               /* bFunctionProtocol: AT commands */
+  0x00,                                               /* iFunction */
+  /* 8 */
+
+  /************** Descriptor of CDC communication interface ****************/
+  0x09,                                               /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,                            /* bDescriptorType: Interface descriptor type */
+  CDC_ITF_COMM,                                       /* bInterfaceNumber: Number of Interface */
+  0x00,                                               /* bAlternateSetting: Alternate setting */
+  0x01,                                               /* bNumEndpoints */
+  0x02,                                               /* bInterfaceClass: Communication Interface Class */
+  0x02,                                               /* bInterfaceSubClass: Abstract Control Model */
+  0x01,                                               /* bInterfaceProtocol: Common AT commands */
+  0,                                                  /* iInterface: Index of string descriptor */
+  /* 17 */
+  0x05,                                               /* bLength: Header Functional Descriptor */
+  0x24,                                               /* bDescriptorType: CS_INTERFACE */
+  0x00,                                               /* bDescriptorSubtype: Header */
+  0x10,                                               /* bcdCDC: spec release number 1.10 */
+  0x01,
+  /* 22 */
+  0x05,                                               /* bLength: Call Management Functional Descriptor */
+  0x24,                                               /* bDescriptorType: CS_INTERFACE */
+  0x01,                                               /* bDescriptorSubtype: Call Management */
+  0x00,                                               /* bmCapabilities: no call management */
+  CDC_ITF_DATA,                                       /* bDataInterface */
+  /* 27 */
+  0x04,                                               /* bLength: ACM Functional Descriptor */
+  0x24,                                               /* bDescriptorType: CS_INTERFACE */
+  0x02,                                               /* bDescriptorSubtype: Abstract Control Management */
+  0x02,                                               /* bmCapabilities: line coding and serial state */
+  /* 31 */
+  0x05,                                               /* bLength: Union Functional Descriptor */
+  0x24,                                               /* bDescriptorType: CS_INTERFACE */
+  0x06,                                               /* bDescriptorSubtype: Union */
+  CDC_ITF_COMM,                                       /* bMasterInterface: Communication class interface */
+  CDC_ITF_DATA,                                       /* bSlaveInterface0: Data Class Interface */
+  /* 36 */
+  0x07,                                               /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
+  CDC_CMD_EPIN_ADDR,                                  /* bEndpointAddress: Endpoint Address (IN) */
+  0x03,                                               /* bmAttributes: Interrupt endpoint */
+  CDC_CMD_EP_SIZE,                                    /* wMaxPacketSize: 8 Bytes max */
+  0x00,
+  CDC_CMD_FS_BINTERVAL,                               /* bInterval: Polling Interval */
+  /* 43 */
+
+  /************** Descriptor of CDC data interface ****************/
+  0x09,                                               /* bLength: Interface Descriptor size */
+  USB_DESC_TYPE_INTERFACE,                            /* bDescriptorType: Interface descriptor type */
+  CDC_ITF_DATA,                                       /* bInterfaceNumber: Number of Interface */
+  0x00,                                               /* bAlternateSetting: Alternate setting */
+  0x02,                                               /* bNumEndpoints */
+  0x0A,                                               /* bInterfaceClass: CDC Data */
+  0x00,                                               /* bInterfaceSubClass */
+  0x00,                                               /* bInterfaceProtocol */
+  0,                                                  /* iInterface: Index of string descriptor */
+  /* 52 */
+  0x07,                                               /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
+  CDC_DATA_EPOUT_ADDR,                                /* bEndpointAddress: Endpoint Address (OUT) */
+  0x02,                                               /* bmAttributes: Bulk endpoint */
+  CDC_DATA_EP_SIZE,                                   /* wMaxPacketSize: 64 Bytes max */
+  0x00,
+  0x00,                                               /* bInterval: ignored for bulk */
+  /* 59 */
+  0x07,                                               /* bLength: Endpoint Descriptor size */
+  USB_DESC_TYPE_ENDPOINT,                             /* bDescriptorType:*/
+  CDC_DATA_EPIN_ADDR,                                 /* bEndpointAddress: Endpoint Address (IN) */
+  0x02,                                               /* bmAttributes: Bulk endpoint */
+  CDC_DATA_EP_SIZE,                                   /* wMaxPacketSize: 64 Bytes max */
+  0x00,
+  0x00,                                               /* bInterval: ignored for bulk */
+  /* 66 */
+};
+
+/* HID configuration descriptor followed by the console function */
+__ALIGN_BEGIN static uint8_t USBD_HID_CDC_CfgDesc[USB_HID_CDC_CONFIG_DESC_SIZ] __ALIGN_END;
+
+__ALIGN_BEGIN static USBD_CDC_Console_HandleTypeDef hcdc __ALIGN_END;
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CDC_CONSOLE_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_HID_CDC_Init
+  *         Initialize the keyboard, then open the console endpoints
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_HID_CDC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  uint8_t ret = USBD_HID.Init(pdev, cfgidx);
+
+  if (ret != (uint8_t)USBD_OK)
+  {
+    return ret;
+  }
+
+  /* Open the CDC notification and data EPs; 115200 8N1 is only reported back */
+  (void)USBD_LL_OpenEP(pdev, CDC_CMD_EPIN_ADDR, USBD_EP_TYPE_INTR, CDC_CMD_EP_SIZE);
+  pdev->ep_in[CDC_CMD_EPIN_ADDR & 0xFU].is_used = 1U;
+  pdev->ep_in[CDC_CMD_EPIN_ADDR & 0xFU].bInterval = CDC_CMD_FS_BINTERVAL;
+
+  (void)USBD_LL_OpenEP(pdev, CDC_DATA_EPIN_ADDR, USBD_EP_TYPE_BULK, CDC_DATA_EP_SIZE);
+  pdev->ep_in[CDC_DATA_EPIN_ADDR & 0xFU].is_used = 1U;
+
+  (void)USBD_LL_OpenEP(pdev, CDC_DATA_EPOUT_ADDR, USBD_EP_TYPE_BULK, CDC_DATA_EP_SIZE);
+  pdev->ep_out[CDC_DATA_EPOUT_ADDR & 0xFU].is_used = 1U;
+  (void)USBD_LL_PrepareReceive(pdev, CDC_DATA_EPOUT_ADDR, hcdc.Rx, CDC_DATA_EP_SIZE);
+
+  hcdc.LineCoding[0] = 0x00U;                         /* dwDTERate: 115200 */
+  hcdc.LineCoding[1] = 0xC2U;
+  hcdc.LineCoding[2] = 0x01U;
+  hcdc.LineCoding[3] = 0x00U;
+  hcdc.LineCoding[4] = 0x00U;                         /* bCharFormat: 1 stop bit */
+  hcdc.LineCoding[5] = 0x00U;                         /* bParityType: none */
+  hcdc.LineCoding[6] = 0x08U;                         /* bDataBits */
+  hcdc.LineState = 0U;
+  hcdc.TxLen = 0U;
+  hcdc.TxBusy = 0U;
+  hcdc.CtlPending = 0U;
+  hcdc.AltSetting = 0U;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_CDC_DeInit
+  *         Close the console endpoints, then DeInitialize the keyboard
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_HID_CDC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  (void)USBD_LL_CloseEP(pdev, CDC_CMD_EPIN_ADDR);
+  pdev->ep_in[CDC_CMD_EPIN_ADDR & 0xFU].is_used = 0U;
+  pdev->ep_in[CDC_CMD_EPIN_ADDR & 0xFU].bInterval = 0U;
+
+  (void)USBD_LL_CloseEP(pdev, CDC_DATA_EPIN_ADDR);
+  pdev->ep_in[CDC_DATA_EPIN_ADDR & 0xFU].is_used = 0U;
+
+  (void)USBD_LL_CloseEP(pdev, CDC_DATA_EPOUT_ADDR);
+  pdev->ep_out[CDC_DATA_EPOUT_ADDR & 0xFU].is_used = 0U;
+
+  hcdc.LineState = 0U;
+  hcdc.TxBusy = 0U;
+
+  return USBD_HID.DeInit(pdev, cfgidx);
+}
+
+/**
+  * @brief  USBD_HID_CDC_Setup
+  *         Route a request to the console when it addresses one of its
+  *         interfaces or endpoints, to the keyboard otherwise
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t USBD_HID_CDC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  uint8_t recipient = req->bmRequest & USB_REQ_RECIPIENT_MASK;
+  uint8_t index = LOBYTE(req->wIndex);
+
+  /* A new SETUP aborts any data stage still pending */
+  hcdc.CtlPending = 0U;
+
+  if (((recipient == USB_REQ_RECIPIENT_INTERFACE) &&
+       ((index == CDC_ITF_COMM) || (index == CDC_ITF_DATA))) ||
+      ((recipient == USB_REQ_RECIPIENT_ENDPOINT) &&
+       ((index == CDC_CMD_EPIN_ADDR) || (index == CDC_DATA_EPIN_ADDR) || (index == CDC_DATA_EPOUT_ADDR))))
+  {
+    return (uint8_t)USBD_CDC_Console_Setup(pdev, req);
+  }
+
+  return USBD_HID.Setup(pdev, req);
+}
+
+/**
+  * @brief  USBD_HID_CDC_EP0_RxReady
+  *         handle the data stage of SET_LINE_CODING or of a keyboard request
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_HID_CDC_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  /* SET_LINE_CODING needs no action: the data already sits in LineCoding */
+  if (hcdc.CtlPending != 0U)
+  {
+    hcdc.CtlPending = 0U;
+    return (uint8_t)USBD_OK;
+  }
+
+  return USBD_HID.EP0_RxReady(pdev);
+}
+
+/**
+  * @brief  USBD_HID_CDC_DataIn
+  *         handle data IN Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_HID_CDC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if (epnum == (CDC_DATA_EPIN_ADDR & 0x7FU))
+  {
+    hcdc.TxBusy = 0U;
+    USBD_CDC_Console_TxNext(pdev);
+    return (uint8_t)USBD_OK;
+  }
+
+  if (epnum == (CDC_CMD_EPIN_ADDR & 0x7FU))
+  {
+    return (uint8_t)USBD_OK;
+  }
+
+  return USBD_HID.DataIn(pdev, epnum);
+}
+
+/**
+  * @brief  USBD_HID_CDC_DataOut
+  *         handle data OUT Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_HID_CDC_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if (epnum == (CDC_DATA_EPOUT_ADDR & 0x7FU))
+  {
+    USBD_CDC_Console_Received(pdev, hcdc.Rx, (uint16_t)USBD_LL_GetRxDataSize(pdev, epnum));
+
+    (void)USBD_LL_PrepareReceive(pdev, CDC_DATA_EPOUT_ADDR, hcdc.Rx, CDC_DATA_EP_SIZE);
+    return (uint8_t)USBD_OK;
+  }
+
+  return USBD_HID.DataOut(pdev, epnum);
+}
+
+/**
+  * @brief  USBD_HID_CDC_SOF
+  *         handle SOF event: keyboard reports first, then console output
+  *         written since the last frame
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_HID_CDC_SOF(USBD_HandleTypeDef *pdev)
+{
+  uint8_t ret = USBD_HID.SOF(pdev);
+
+  USBD_CDC_Console_TxNext(pdev);
+
+  return ret;
+}
+
+/**
+  * @brief  USBD_HID_CDC_BuildCfgDesc
+  *         Append the console function to a HID configuration descriptor
+  *         and fix up the total length and interface count
+  * @param  hid_desc: HID configuration descriptor
+  * @param  hid_len: its length
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_HID_CDC_BuildCfgDesc(const uint8_t *hid_desc, uint16_t hid_len, uint16_t *length)
+{
+  uint16_t total;
+
+  hid_len = MIN(hid_len, USB_HID_CONFIG_DESC_SIZ);
+  total = hid_len + USB_CDC_CONSOLE_DESC_SIZ;
+
+  (void)USBD_memcpy(USBD_HID_CDC_CfgDesc, hid_desc, hid_len);
+  (void)USBD_memcpy(&USBD_HID_CDC_CfgDesc[hid_len], USBD_CDC_Console_Desc, USB_CDC_CONSOLE_DESC_SIZ);
+
+  USBD_HID_CDC_CfgDesc[2] = LOBYTE(total);            /* wTotalLength */
+  USBD_HID_CDC_CfgDesc[3] = HIBYTE(total);
+  USBD_HID_CDC_CfgDesc[4] = CDC_ITF_DATA + 1U;        /* bNumInterfaces */
+
+  *length = total;
+  return USBD_HID_CDC_CfgDesc;
+}
+
+/**
+  * @brief  USBD_HID_CDC_GetFSCfgDesc
+  *         return FS configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_HID_CDC_GetFSCfgDesc(uint16_t *length)
+{
+  uint16_t hid_len;
+  uint8_t *hid_desc = USBD_HID.GetFSConfigDescriptor(&hid_len);
+
+  return USBD_HID_CDC_BuildCfgDesc(hid_desc, hid_len, length);
+}
+
+/**
+  * @brief  USBD_HID_CDC_GetHSCfgDesc
+  *         return HS configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_HID_CDC_GetHSCfgDesc(uint16_t *length)
+{
+  uint16_t hid_len;
+  uint8_t *hid_desc = USBD_HID.GetHSConfigDescriptor(&hid_len);
+
+  return USBD_HID_CDC_BuildCfgDesc(hid_desc, hid_len, length);
+}
+
+/**
+  * @brief  USBD_HID_CDC_GetOtherSpeedCfgDesc
+  *         return other speed configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_HID_CDC_GetOtherSpeedCfgDesc(uint16_t *length)
+{
+  uint16_t hid_len;
+  uint8_t *hid_desc = USBD_HID.GetOtherSpeedConfigDescriptor(&hid_len);
+
+  return USBD_HID_CDC_BuildCfgDesc(hid_desc, hid_len, length);
+}
+
+/**
+  * @brief  USBD_HID_CDC_GetDeviceQualifierDesc
+  *         return Device Qualifier descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_HID_CDC_GetDeviceQualifierDesc(uint16_t *length)
+{
+  return USBD_HID.GetDeviceQualifierDescriptor(length);
+}
+
+/**
+  * @brief  USBD_CDC_Console_Setup
+  *         Handle the CDC-ACM class requests and the standard requests
+  *         addressed to the console interfaces or endpoints
+  * @param  pdev: device instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static USBD_StatusTypeDef USBD_CDC_Console_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  uint16_t status_info = 0U;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS:
+      switch (req->bRequest)
+      {
+        case CDC_REQ_SET_LINE_CODING:
+          if (req->wLength != CDC_LINE_CODING_SIZE)
+          {
+            break;
+          }
+          hcdc.CtlPending = 1U;
+          (void)USBD_CtlPrepareRx(pdev, hcdc.LineCoding, CDC_LINE_CODING_SIZE);
+          return USBD_OK;
+
+        case CDC_REQ_GET_LINE_CODING:
+          (void)USBD_CtlSendData(pdev, hcdc.LineCoding, MIN(CDC_LINE_CODING_SIZE, req->wLength));
+          return USBD_OK;
+
+        case CDC_REQ_SET_CONTROL_LINE_STATE:
+          /* Output is held in the console ring until a terminal opens the port (DTR) */
+          hcdc.LineState = LOBYTE(req->wValue);
+          return USBD_OK;
+
+        case CDC_REQ_SEND_BREAK:
+          return USBD_OK;
+
+        default:
+          break;
+      }
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+            return USBD_OK;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, &hcdc.AltSetting, 1U);
+            return USBD_OK;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE:
+          /* Both interfaces only have alternate setting 0 */
+          if ((pdev->dev_state == USBD_STATE_CONFIGURED) && (req->wValue == 0U))
+          {
+            return USBD_OK;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          return USBD_OK;
+
+        default:
+          break;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  USBD_CtlError(pdev, req);
+  return USBD_FAIL;
+}
+
+/**
+  * @brief  USBD_CDC_Console_TxNext
+  *         Send the next chunk of console output on the bulk IN endpoint;
+  *         a full packet with nothing behind it is followed by a
+  *         zero-length packet so the host completes the transfer
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void USBD_CDC_Console_TxNext(USBD_HandleTypeDef *pdev)
+{
+  uint16_t len;
+
+  if ((hcdc.TxBusy != 0U) || ((hcdc.LineState & CDC_CONTROL_LINE_DTR) == 0U))
+  {
+    return;
+  }
+
+  len = USBD_CDC_Console_TxFill(pdev, hcdc.Tx, CDC_DATA_EP_SIZE);
+
+  if ((len == 0U) && (hcdc.TxLen != CDC_DATA_EP_SIZE))
+  {
+    return;
+  }
+
+  hcdc.TxLen = (uint8_t)len;
+  hcdc.TxBusy = 1U;
+  (void)USBD_LL_Transmit(pdev, CDC_DATA_EPIN_ADDR, hcdc.Tx, len);
+}
+
+/**
+  * @brief  USBD_CDC_Console_TxFill
+  *         Called from the USB interrupt when the console bulk IN endpoint
+  *         is free; override to copy pending output into buf
+  * @param  pdev: device instance
+  * @param  buf: packet buffer
+  * @param  max: buffer size (CDC_DATA_EP_SIZE)
+  * @retval number of bytes to send, 0 if none
+  */
+__weak uint16_t USBD_CDC_Console_TxFill(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t max)
+{
+  UNUSED(pdev);
+  UNUSED(buf);
+  UNUSED(max);
+
+  return 0U;
+}
+
+/**
+  * @brief  USBD_CDC_Console_Received
+  *         Called from the USB interrupt for each packet received on the
+  *         console bulk OUT endpoint; override to handle the input
+  * @param  pdev: device instance
+  * @param  buf: received data, valid until this function returns
+  * @param  len: number of bytes received
+  * @retval None
+  */
+__weak void USBD_CDC_Console_Received(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t len)
+{
+  UNUSED(pdev);
+  UNUSED(buf);
+  UNUSED(len);
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#endif /* USBD_CDC_CONSOLE */
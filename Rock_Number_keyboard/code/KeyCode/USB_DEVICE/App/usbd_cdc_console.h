@@ -0,0 +1,98 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_console.h
+  * @brief          : Header for usbd_cdc_console.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CDC_CONSOLE_H
+#define __USBD_CDC_CONSOLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_hid.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_CDC_CONSOLE
+  * @brief CDC-ACM diagnostic console next to the boot keyboard
+  * @{
+  */
+
+/** @defgroup USBD_CDC_CONSOLE_Exported_Defines
+  * @{
+  */
+/* OTG_FS has three IN endpoints besides EP0: the console reuses EP2/EP3,
+   which the HID class leaves free when built keyboard-only */
+#define CDC_CMD_EPIN_ADDR                          0x82U
+#define CDC_CMD_EP_SIZE                            0x08U   /* notification, never sent */
+#define CDC_CMD_FS_BINTERVAL                       0x10U
+
+#define CDC_DATA_EPIN_ADDR                         0x83U
+#define CDC_DATA_EPOUT_ADDR                        0x03U
+#define CDC_DATA_EP_SIZE                           0x40U   /* bulk, both directions */
+
+/* Interfaces of the console function, after the HID ones */
+#define CDC_ITF_COMM                               HID_ITF_NUM
+#define CDC_ITF_DATA                               (HID_ITF_NUM + 1U)
+
+#define USB_CDC_CONSOLE_DESC_SIZ                   66U     /* IAD and both interfaces */
+#define USB_HID_CDC_CONFIG_DESC_SIZ                (USB_HID_CONFIG_DESC_SIZ + USB_CDC_CONSOLE_DESC_SIZ)
+
+#define CDC_REQ_SET_LINE_CODING                    0x20U
+#define CDC_REQ_GET_LINE_CODING                    0x21U
+#define CDC_REQ_SET_CONTROL_LINE_STATE             0x22U
+#define CDC_REQ_SEND_BREAK                         0x23U
+#define CDC_LINE_CODING_SIZE                       7U
+#define CDC_CONTROL_LINE_DTR                       0x01U
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CDC_CONSOLE_Exported_Variables
+  * @{
+  */
+
+/* Boot keyboard (interface 0, USBD_HID) plus the console (interfaces 1-2) */
+extern USBD_ClassTypeDef USBD_HID_CDC;
+#define USBD_HID_CDC_CLASS &USBD_HID_CDC
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CDC_CONSOLE_Exported_Functions
+  * @{
+  */
+uint16_t USBD_CDC_Console_TxFill(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t max);
+void USBD_CDC_Console_Received(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t len);
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_CDC_CONSOLE_H */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -63,19 +63,32 @@
   */
 
 /*---------- -----------*/
-#define USBD_MAX_NUM_INTERFACES     1U
+#define USBD_MAX_NUM_INTERFACES     3U
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     1U
 /*---------- -----------*/
 #define USBD_MAX_STR_DESC_SIZ     512U
 /*---------- -----------*/
+/* 1: add a CDC-ACM diagnostic console (/dev/ttyACMx, usbd_cdc_console.c);
+   it takes over the EP2/EP3 endpoints of the NKRO and raw HID interfaces.
+   NOTE: a CDC build loses NKRO, consumer control (media keys), system
+   control and raw HID; the keyboard only sends 6-key boot reports */
+#define USBD_CDC_CONSOLE     0U
+/*---------- -----------*/
+/* 1: HID class with the boot keyboard interface only (no EP2/EP3) */
+#define USBD_HID_KEYBOARD_ONLY     USBD_CDC_CONSOLE
+/*---------- -----------*/
+#if (USBD_CDC_CONSOLE == 1U)
+#define USBD_DEBUG_LEVEL     2U
+#else
 #define USBD_DEBUG_LEVEL     0U
+#endif /* USBD_CDC_CONSOLE */
 /*---------- -----------*/
 #define USBD_LPM_ENABLED     0U
 /*---------- -----------*/
 #define USBD_SELF_POWERED     1U
 /*---------- -----------*/
-#define HID_FS_BINTERVAL     0xAU
+#define HID_FS_BINTERVAL     0x1U
 
 /****************************************/
 /* #define for FS and HS identification */
@@ -109,26 +122,34 @@
 
 /* DEBUG macros */
 
+#if (USBD_CDC_CONSOLE == 1U)
+/* Log through the console ring: never blocks, callable from the USB interrupt */
+#include "console.h"
+#define USBD_LOG_PRINTF     Console_Printf
+#else
+#define USBD_LOG_PRINTF     printf
+#endif /* USBD_CDC_CONSOLE */
+
 #if (USBD_DEBUG_LEVEL > 0)
-#define USBD_UsrLog(...)    printf(__VA_ARGS__);\
-                            printf("\n");
+#define USBD_UsrLog(...)    USBD_LOG_PRINTF(__VA_ARGS__);\
+                            USBD_LOG_PRINTF("\r\n");
 #else
 #define USBD_UsrLog(...)
 #endif /* (USBD_DEBUG_LEVEL > 0U) */
 
 #if (USBD_DEBUG_LEVEL > 1)
 
-#define USBD_ErrLog(...)    printf("ERROR: ");\
-                            printf(__VA_ARGS__);\
-                            printf("\n");
+#define USBD_ErrLog(...)    USBD_LOG_PRINTF("ERROR: ");\
+                            USBD_LOG_PRINTF(__VA_ARGS__);\
+                            USBD_LOG_PRINTF("\r\n");
 #else
 #define USBD_ErrLog(...)
 #endif /* (USBD_DEBUG_LEVEL > 1U) */
 
 #if (USBD_DEBUG_LEVEL > 2)
-#define USBD_DbgLog(...)    printf("DEBUG : ");\
-                            printf(__VA_ARGS__);\
-                            printf("\n");
+#define USBD_DbgLog(...)    USBD_LOG_PRINTF("DEBUG : ");\
+                            USBD_LOG_PRINTF(__VA_ARGS__);\
+                            USBD_LOG_PRINTF("\r\n");
 #else
 #define USBD_DbgLog(...)
 #endif /* (USBD_DEBUG_LEVEL > 2U) */